@@ -0,0 +1,181 @@
+#include <assert.h>
+#include <fstream>
+
+#include "Anim.h"
+#include "Utils.h"
+#include "GameObj.h"
+
+using namespace sf;
+using namespace std;
+
+//names the game code looks up, must match the order of AnimSys::ClipT
+const char* CLIP_NAMES[(int)AnimSys::ClipT::COUNT]{
+	"knight_idle", "knight_walk", "knight_attack", "ghost", "wolf"
+};
+
+/*
+Fallback for any clip the data file doesn't have (or the file is missing),
+the original knight sheet values and the first frames of the enemy sheet
+*/
+AnimClip DefaultClip(AnimSys::ClipT which)
+{
+	AnimClip clip;
+	clip.name = CLIP_NAMES[(int)which];
+	switch (which)
+	{
+	case AnimSys::ClipT::KnightIdle:
+		clip.frames = { {518,20,64,60}, {582,20,64,60}, {646,20,64,60}, {710,20,64,60} };
+		break;
+	case AnimSys::ClipT::KnightWalk:
+		for (int i = 0; i < 8; ++i)
+			clip.frames.push_back(IntRect(10 + i * 64, 20, 64, 60));
+		break;
+	case AnimSys::ClipT::KnightAttack:
+		clip.frames = { {783,9,54,65}, {856,9,54,65}, {929,9,54,65}, {999,9,54,65},
+			{1056,9,54,65}, {1130,9,54,65}, {1210,9,54,65} };
+		break;
+	case AnimSys::ClipT::Ghost:
+		clip.frameTime = 0.2f;
+		clip.loop = AnimClip::LoopT::PingPong;
+		clip.frames = { {0,0,64,64}, {64,0,64,64} };
+		break;
+	case AnimSys::ClipT::Wolf:
+		clip.frameTime = 0.15f;
+		clip.frames = { {128,0,64,64}, {192,0,64,64} };
+		break;
+	default:
+		assert(false);
+	}
+	return clip;
+}
+
+bool AnimSys::Load(const string& path)
+{
+	clips.clear();
+	bool loaded = false;
+	ifstream fs;
+	fs.open(path);
+	if (fs.is_open() && fs.good())
+	{
+		string name;
+		while (fs >> name)
+		{
+			if (name[0] == '#') {
+				getline(fs, name);	//comment, skip the rest of the line
+				continue;
+			}
+			AnimClip clip;
+			clip.name = name;
+			string loop;
+			int numFrames = 0;
+			fs >> clip.frameTime >> loop >> numFrames;
+			if (loop == "once")
+				clip.loop = AnimClip::LoopT::Once;
+			else if (loop == "pingpong")
+				clip.loop = AnimClip::LoopT::PingPong;
+			for (int i = 0; i < numFrames && fs.good(); ++i)
+			{
+				IntRect r;
+				fs >> r.left >> r.top >> r.width >> r.height;
+				clip.frames.push_back(r);
+			}
+			if (fs.fail() || clip.frames.empty() || clip.frameTime <= 0)
+			{
+				//can't tell where the next clip starts, keep what we have and fill the gaps below
+				DebugPrint("Bad animation clip: ", name);
+				loaded = false;
+				break;
+			}
+			clips.push_back(clip);
+			loaded = true;
+		}
+		fs.close();
+	}
+
+	//every clip the game asks for must exist, so GetId never hands back -1
+	for (int i = 0; i < (int)ClipT::COUNT; ++i)
+	{
+		clipIds[i] = FindClip(CLIP_NAMES[i]);
+		if (clipIds[i] < 0)
+		{
+			DebugPrint("Missing animation clip, using the default: ", CLIP_NAMES[i]);
+			clips.push_back(DefaultClip((ClipT)i));
+			clipIds[i] = (int)clips.size() - 1;
+			loaded = false;
+		}
+	}
+	return loaded;
+}
+
+int AnimSys::FindClip(const string& name) const
+{
+	for (size_t i = 0; i < clips.size(); ++i)
+		if (clips[i].name == name)
+			return (int)i;
+	return -1;
+}
+
+void AnimSys::Play(AnimState& state, int clipId, bool restart) const
+{
+	assert(clipId >= 0 && clipId < (int)clips.size());
+	if (state.clipId == clipId && !restart)
+		return;
+	state.clipId = (short)clipId;
+	state.frameIdx = 0;
+	state.time = 0;
+	state.reverse = false;
+	state.changed = true;
+}
+
+void AnimSys::Advance(AnimState& state, float dT) const
+{
+	const AnimClip& clip = clips[state.clipId];
+	const int last = (int)clip.frames.size() - 1;
+	state.time += dT;
+	while (state.time >= clip.frameTime)
+	{
+		state.time -= clip.frameTime;
+		int idx = state.frameIdx + (state.reverse ? -1 : 1);
+		if (idx > last || idx < 0)
+		{
+			switch (clip.loop)
+			{
+			case AnimClip::LoopT::Loop:
+				idx = 0;
+				break;
+			case AnimClip::LoopT::Once:
+				idx = last;
+				state.time = 0;	//hold on the last frame
+				break;
+			case AnimClip::LoopT::PingPong:
+				state.reverse = !state.reverse;
+				idx = (last > 0) ? state.frameIdx + (state.reverse ? -1 : 1) : 0;
+				break;
+			}
+		}
+		if (idx != state.frameIdx)
+		{
+			state.frameIdx = (unsigned short)idx;
+			state.changed = true;
+		}
+		if (clip.loop == AnimClip::LoopT::Once && idx == last)
+			break;
+	}
+}
+
+void AnimSys::Update(float dT, vector<GameObj>& objects, const vector<unsigned int>& which) const
+{
+	for (size_t i = 0; i < which.size(); ++i)
+	{
+		GameObj& obj = objects[which[i]];
+		if (obj.active && obj.anim.IsPlaying())
+		{
+			Advance(obj.anim, dT);
+			if (obj.anim.changed)
+			{
+				obj.spr.setTextureRect(GetFrame(obj.anim));
+				obj.anim.changed = false;
+			}
+		}
+	}
+}
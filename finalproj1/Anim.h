@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <assert.h>
+
+#include "SFML/Graphics.hpp"
+
+struct GameObj;
+
+/*
+One animation - a list of frames on a sprite sheet played back at a fixed rate
+Clips are loaded from a text file so new animations don't need new code
+*/
+struct AnimClip {
+	enum class LoopT { Loop, Once, PingPong };	//what to do after the last frame
+	std::string name;					//used to look the clip up after loading
+	std::vector<sf::IntRect> frames;	//texture rectangles, in playback order
+	float frameTime = 1.f / 8.f;		//seconds each frame stays on screen
+	LoopT loop = LoopT::Loop;
+};
+
+/*
+Per object playback state, kept tiny as every animating object has one
+and we want thousands of enemies to be cheap
+*/
+struct AnimState {
+	short clipId = -1;			//index into AnimSys::clips, -1 means not animating
+	unsigned short frameIdx = 0;//current frame in the clip
+	float time = 0;				//seconds spent on the current frame
+	bool reverse = false;		//PingPong clips play backwards on the way back
+	bool changed = false;		//frame changed since the texture rect was last set
+
+	bool IsPlaying() const {
+		return clipId >= 0;
+	}
+};
+
+/*
+Owns every clip and advances every animating object in one pass per frame
+*/
+struct AnimSys {
+	//clips the game code refers to directly, resolved by name when loading
+	enum class ClipT { KnightIdle, KnightWalk, KnightAttack, Ghost, Wolf, COUNT };
+
+	std::vector<AnimClip> clips;	//everything loaded from file
+	int clipIds[(int)ClipT::COUNT];	//ClipT -> index into clips, -1 if missing
+
+	/*
+	Load clips from a text file, one clip per block:
+	name frameTime loop|once|pingpong numFrames
+	then numFrames lines of: left top width height
+	Any clip the game needs that isn't in the file (or the file can't be read,
+	or a bad clip stops it early) gets its built in default
+	returns - true if every clip came from the file
+	*/
+	bool Load(const std::string& path);
+	//index of a named clip or -1
+	int FindClip(const std::string& name) const;
+	int GetId(ClipT clip) const {
+		return clipIds[(int)clip];
+	}
+	//start playing a clip, does nothing if it's already playing unless restart is set
+	void Play(AnimState& state, int clipId, bool restart = false) const;
+	//move one state on by dT seconds
+	void Advance(AnimState& state, float dT) const;
+	//the texture rectangle a state is currently showing
+	const sf::IntRect& GetFrame(const AnimState& state) const {
+		assert(state.clipId >= 0 && state.clipId < (int)clips.size());
+		return clips[state.clipId].frames[state.frameIdx];
+	}
+	/*
+	Advance animating objects and update their sprites
+	which - indices of the objects to do, anything not in it (e.g. off screen) keeps its frame
+	*/
+	void Update(float dT, std::vector<GameObj>& objects, const std::vector<unsigned int>& which) const;
+};
@@ -0,0 +1,485 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+#include "Bench.h"
+#include "Game.h"
+#include "SoftwareBackend.h"
+
+using namespace sf;
+using namespace std;
+
+namespace GC
+{
+	const int BENCH_CIRCLES = 4096;	//how many circles in the narrow phase test
+	const int BENCH_PARTICLES = 200000;	//particle cache size for the effects test
+	const float BENCH_DT = 1.f / 60.f;	//fixed frame time for simulated updates
+	const int GOLDEN_FRAMES = 60;		//updates to run before the in game golden image
+	const float GOLDEN_MAX_DIFF = 0.001f;	//fraction of pixels allowed to be different before a golden test fails
+	const int BENCH_OBJECTS = 1000;		//active objects in the snapshot stress scene
+	const int BENCH_EMITTERS = 1000;	//effects going off in the snapshot stress scene
+	const int BENCH_REPEATS = 50;		//snapshots saved and loaded to time
+	const int BENCH_REPLAY_FRAMES = 30;	//whole game updates run from a snapshot to check it replays the same
+	const Vector2u BENCH_SCREEN((unsigned)SCREEN_RES.x, (unsigned)SCREEN_RES.y);	//screen size for whole game tests
+	const int BENCH_SHOTS = 50000;		//bullets kept in flight in the projectile test
+	const int BENCH_SHOOTERS = 100;		//enemies firing rings of bullets
+	const int BENCH_RING = 32;			//bullets in each ring
+	const int BENCH_FRAMES = 120;		//updates timed in the projectile test
+	const int BENCH_REBUILDS = 1000;	//times the player is moved to a new cell in the flow field test
+	const int BENCH_MAX_THREADS = 16;	//the parallel collision test goes 1, 2, 4 ... up to this
+	const float BENCH_COLLIDE_MS = 500;	//roughly how long to spend timing each object count and thread count
+}
+
+void RunBenchmarks(ostream& out)
+{
+	out << "Legend Quest 2D benchmarks\n\n";
+	BenchNarrowPhase(out);
+	BenchEffects(out);
+	BenchSnapshot(out);
+	BenchStressScene(out);
+	BenchProjectiles(out);
+	BenchFlowField(out);
+	BenchParallelCollisions(out);
+}
+
+/*
+The original narrow phase test, kept as the baseline so the speed up
+is measured against what the game used to do
+*/
+bool SqrtCircleToCircle(const Vector2f& pos1, const Vector2f& pos2, float minDist)
+{
+	float dist = (pos1.x - pos2.x) * (pos1.x - pos2.x) +
+		(pos1.y - pos2.y) * (pos1.y - pos2.y);
+	dist = sqrtf(dist);
+	return dist <= minDist;
+}
+
+void BenchNarrowPhase(ostream& out)
+{
+	srand(1);
+	vector<Vector2f> pos(GC::BENCH_CIRCLES);
+	vector<float> rad(GC::BENCH_CIRCLES);
+	CircleSoA soa;
+	soa.Resize(GC::BENCH_CIRCLES);
+	for (int i = 0; i < GC::BENCH_CIRCLES; ++i)
+	{
+		pos[i] = Vector2f((float)(rand() % GC::SCREEN_RES.x), (float)(rand() % GC::SCREEN_RES.y));
+		rad[i] = GC::ROCK_RAD.x + (float)(rand() % (int)(GC::ROCK_RAD.y - GC::ROCK_RAD.x));
+		soa.Set(i, pos[i].x, pos[i].y, rad[i], i);
+	}
+
+	Clock clock;
+	int sqrtHits = 0;
+	for (int i = 0; i < GC::BENCH_CIRCLES; ++i)
+		for (int ii = 0; ii < GC::BENCH_CIRCLES; ++ii)
+			if (SqrtCircleToCircle(pos[i], pos[ii], rad[i] + rad[ii]))
+				++sqrtHits;
+	float sqrtTime = clock.restart().asSeconds();
+
+	int scalarHits = 0;
+	for (int i = 0; i < GC::BENCH_CIRCLES; ++i)
+		for (int ii = 0; ii < GC::BENCH_CIRCLES; ++ii)
+			if (CircleToCircle(pos[i], pos[ii], rad[i] + rad[ii]))
+				++scalarHits;
+	float scalarTime = clock.restart().asSeconds();
+
+	int simdHits = 0;
+	for (int i = 0; i < GC::BENCH_CIRCLES; ++i)
+		CircleVsRange(pos[i].x, pos[i].y, rad[i], soa, 0, GC::BENCH_CIRCLES, [&simdHits](int) { ++simdHits; });
+	float simdTime = clock.restart().asSeconds();
+
+	float tests = (float)GC::BENCH_CIRCLES * GC::BENCH_CIRCLES;
+	out << "Narrow phase, " << GC::BENCH_CIRCLES << " x " << GC::BENCH_CIRCLES << " circles\n";
+	out << "  sqrtf original   " << sqrtTime * 1000.f << "ms " << (sqrtTime * 1e9f) / tests << "ns/test hits=" << sqrtHits << "\n";
+	out << "  CircleToCircle   " << scalarTime * 1000.f << "ms " << (scalarTime * 1e9f) / tests << "ns/test hits=" << scalarHits << "\n";
+	out << "  CircleVsCircles8 " << simdTime * 1000.f << "ms " << (simdTime * 1e9f) / tests << "ns/test hits=" << simdHits << "\n";
+	out << "  speedup x" << ((simdTime > 0) ? sqrtTime / simdTime : 0.f) << " over the original, x"
+		<< ((simdTime > 0) ? scalarTime / simdTime : 0.f) << " over squared distances\n\n";
+	assert(sqrtHits == scalarHits && scalarHits == simdHits);
+}
+
+void BenchEffects(ostream& out)
+{
+	srand(1);
+	ParticleSys sys;
+	out << "Particle effects, " << GC::BENCH_PARTICLES << " particle cache\n";
+	const int counts[]{ 10, 100, 1000 };
+	for (int n : counts)
+	{
+		sys.Init(n, ParticleSys::OverflowT::Drop, GC::BENCH_PARTICLES, false);
+		for (int i = 0; i < n; ++i)
+		{
+			EffectReq req{ (EffectT)(i % (int)EffectT::COUNT),
+				Vector2f((float)(rand() % GC::SCREEN_RES.x), (float)(rand() % GC::SCREEN_RES.y)),
+				Vector2f(0, 0), GC::ROCK_RAD.y };
+			sys.SpawnEffect(req);
+		}
+		Clock clock;
+		double particleUpdates = 0;
+		int frames = 0, peak = 0;
+		while (sys.GetNumActiveEmitters() > 0 || sys.cache.IsBusy())
+		{
+			particleUpdates += sys.cache.numBusy;
+			sys.Update(GC::BENCH_DT);
+			peak = max(peak, sys.cache.numBusy);
+			++frames;
+		}
+		float secs = clock.getElapsedTime().asSeconds();
+		out << "  " << n << " effects: " << frames << " frames in " << secs * 1000.f << "ms, peak "
+			<< peak << " particles, " << ((secs > 0) ? particleUpdates / secs : 0) << " particles/s\n";
+	}
+	out << "\n";
+}
+
+void SetupStressGame(Game& game)
+{
+	game.Init(GC::BENCH_SCREEN, true);
+	game.metrics.Restart();
+	game.mode = Game::Mode::GAME;
+	game.NewGame(GC::BENCH_SCREEN);
+	//the player stays where it is, everything else can be filled in
+	game.objects.resize(GC::BENCH_OBJECTS);
+	for (size_t i = 0; i < game.objects.size(); ++i)
+		game.objects[i].pGame = &game;
+	game.particleSys.Init(GC::BENCH_EMITTERS, ParticleSys::OverflowT::Drop, GC::BENCH_PARTICLES, false);
+	game.rng.Seed(1);
+}
+
+void StepStressGame(Game& game, int frames)
+{
+	InputState input;
+	for (int i = 0; i < frames; ++i)
+	{
+		game.UpdateInGame(GC::BENCH_SCREEN, GC::BENCH_DT, input);
+		game.EndFrame();
+	}
+}
+
+void BenchSnapshot(ostream& out)
+{
+	//a stress scene: lots of objects and a full particle cache
+	Game game;
+	SetupStressGame(game);
+	for (size_t i = 1; i < game.objects.size(); ++i)
+	{
+		GameObj& obj = game.objects[i];
+		obj.active = true;
+		obj.type = (i % 2) ? GameObj::ObjectT::Enemy : GameObj::ObjectT::Rock;
+		obj.radius = GC::ROCK_RAD.x + game.rng.Range((int)(GC::ROCK_RAD.y - GC::ROCK_RAD.x));
+		obj.spr.setPosition((float)game.rng.Range(GC::SCREEN_RES.x), (float)game.rng.Range(GC::SCREEN_RES.y));
+	}
+	ParticleSys& sys = game.particleSys;
+	for (int i = 0; i < GC::BENCH_EMITTERS; ++i)
+	{
+		EffectReq req{ (EffectT)(i % (int)EffectT::COUNT), game.objects[i % game.objects.size()].spr.getPosition(),
+			Vector2f(0, 0), GC::ROCK_RAD.y };
+		sys.SpawnEffect(req);
+	}
+	for (int i = 0; i < 10; ++i)
+		sys.Update(GC::BENCH_DT);
+
+	Snapshot snap;
+	Clock clock;
+	for (int i = 0; i < GC::BENCH_REPEATS; ++i)
+		game.SaveSnapshot(snap);
+	float saveTime = clock.restart().asSeconds() / GC::BENCH_REPEATS;
+	bool loaded = true;
+	for (int i = 0; i < GC::BENCH_REPEATS; ++i)
+		loaded = game.LoadSnapshot(snap) && loaded;
+	float loadTime = clock.restart().asSeconds() / GC::BENCH_REPEATS;
+	assert(loaded);
+
+	//carrying on from a restored snapshot must give exactly what carrying on from the original did,
+	//the whole game is run (collisions, enemies, spawning, bullets) not just the particles
+	StepStressGame(game, GC::BENCH_REPLAY_FRAMES);
+	Snapshot after;
+	game.SaveSnapshot(after);
+	loaded = game.LoadSnapshot(snap) && loaded;
+	StepStressGame(game, GC::BENCH_REPLAY_FRAMES);
+	Snapshot again;
+	game.SaveSnapshot(again);
+	bool same = loaded && after.data == again.data;
+	assert(same);
+
+	out << "Snapshots, " << GC::BENCH_OBJECTS << " objects " << sys.cache.numBusy << " particles "
+		<< sys.GetNumActiveEmitters() << " emitters\n";
+	out << "  " << snap.data.size() / 1024 << "KB, save " << saveTime * 1e6f << "us, load " << loadTime * 1e6f << "us, "
+		<< (same ? "replay matches" : "REPLAY DIFFERS") << "\n";
+	out << "  " << (snap.SaveToFile("stress.bin") ? "saved to stress.bin" : "couldn't save stress.bin") << "\n\n";
+}
+
+void BenchStressScene(ostream& out)
+{
+	Game game;
+	SetupStressGame(game);
+	Snapshot snap;
+	out << "Stress scene from stress.bin\n";
+	if (!snap.LoadFromFile("stress.bin") || !game.LoadSnapshot(snap))
+	{
+		out << "  couldn't load stress.bin, run BenchSnapshot first\n\n";
+		return;
+	}
+	Clock clock;
+	StepStressGame(game, GC::BENCH_FRAMES);
+	float perFrame = clock.getElapsedTime().asSeconds() * 1000.f / GC::BENCH_FRAMES;
+	int numActive = 0;
+	for (const GameObj& obj : game.objects)
+		numActive += obj.active ? 1 : 0;
+	out << "  " << GC::BENCH_FRAMES << " whole game updates, " << perFrame << "ms per frame, "
+		<< numActive << " objects " << game.particleSys.cache.numBusy << " particles "
+		<< game.projectiles.num << " bullets left\n\n";
+}
+
+bool RunGoldenTests(const Vector2u& sz, ostream& out, bool update)
+{
+	Game game;
+	game.rng.Seed(1);
+	game.Init(sz, true);
+	SoftwareBackend gfx(sz.x, sz.y, &game.workers);
+	for (const Game::TexImage& ti : game.texImages)
+		gfx.RegisterImage(ti.pTex, ti.img);
+	out << "Golden images, " << sz.x << "x" << sz.y << " on " << game.workers.GetNumThreads() << " threads\n";
+
+	bool passed = true;
+	auto check = [&](const string& name) {
+		Clock clock;
+		gfx.stats.Reset();
+		gfx.Clear();
+		game.Render(gfx, GC::BENCH_DT);
+		Image img = gfx.GetImage();
+		float ms = clock.getElapsedTime().asSeconds() * 1000.f;
+		out << "  " << name << ": " << ms << "ms " << gfx.stats.drawCalls << " draws " << gfx.stats.pixels << " pixels, ";
+
+		const string path = "golden/" + name + ".png";
+		if (update)
+		{
+			bool saved = img.saveToFile(path);
+			out << (saved ? "saved new reference\n" : "FAIL couldn't save reference\n");
+			passed = passed && saved;
+			return;
+		}
+		Image ref;
+		if (!ref.loadFromFile(path))
+		{
+			out << "FAIL no reference, run with -golden -update to make one\n";
+			img.saveToFile("golden/" + name + "_fail.png");
+			passed = false;
+			return;
+		}
+		float diff = CompareImages(img, ref);
+		bool ok = diff <= GC::GOLDEN_MAX_DIFF;
+		out << (ok ? "pass" : "FAIL") << " (" << diff * 100.f << "% different)\n";
+		if (!ok)
+		{
+			img.saveToFile("golden/" + name + "_fail.png");
+			passed = false;
+		}
+	};
+
+	check("intro");
+	//press fire long enough after starting to get into the game, then play without touching anything
+	InputState input;
+	input.Tap(Keyboard::Space);
+	game.Update(sz, 1.f, input);
+	game.EndFrame();
+	input.BeginFrame();
+	for (int i = 0; i < GC::GOLDEN_FRAMES; ++i)
+	{
+		game.Update(sz, GC::BENCH_DT, input);
+		game.EndFrame();
+	}
+	check("game");
+	game.mode = Game::Mode::GAME_OVER;
+	check("game_over");
+	out << (passed ? "All passed\n\n" : "Some FAILED\n\n");
+	return passed;
+}
+
+void BenchProjectiles(ostream& out)
+{
+	Game game;
+	game.rng.Seed(1);
+	game.frameArena.Init(GC::FRAME_ARENA_BYTES);
+	game.projectiles.Init(nullptr);
+	game.objects.resize(GC::BENCH_SHOOTERS + 1);
+	for (size_t i = 0; i < game.objects.size(); ++i)
+	{
+		GameObj& obj = game.objects[i];
+		obj.active = true;
+		obj.type = (i == 0) ? GameObj::ObjectT::player : GameObj::ObjectT::Enemy;
+		obj.radius = GC::ROCK_RAD.x;
+		obj.spr.setPosition((float)game.rng.Range(GC::SCREEN_RES.x), (float)game.rng.Range(GC::SCREEN_RES.y));
+	}
+	const FloatRect area(-GC::PROJECTILE_SIZE, -GC::PROJECTILE_SIZE,
+		GC::SCREEN_RES.x + GC::PROJECTILE_SIZE * 2, GC::SCREEN_RES.y + GC::PROJECTILE_SIZE * 2);
+	SoftwareBackend gfx(GC::SCREEN_RES.x, GC::SCREEN_RES.y);
+
+	//each frame the shooters top the bullets back up with rings, turning a little each time
+	Projectiles& shots = game.projectiles;
+	float spin = 0;
+	auto topUp = [&]() {
+		while (shots.num + GC::BENCH_RING <= GC::BENCH_SHOTS)
+		{
+			int who = 1 + game.rng.Range(GC::BENCH_SHOOTERS);
+			const Vector2f& pos = game.objects[who].spr.getPosition();
+			for (int i = 0; i < GC::BENCH_RING; ++i)
+			{
+				float angle = spin + i * 2 * GC::PI / GC::BENCH_RING;
+				shots.Fire(pos, Vector2f(cosf(angle), sinf(angle)) * GC::ENEMY_BULLET_SPEED, Layer::EnemyBullet, who);
+			}
+			spin += 0.1f;
+		}
+	};
+
+	shots.SetArea(area);
+	float updateTime = 0, collideTime = 0, renderTime = 0;
+	size_t numContacts = 0;
+	Clock clock;
+	for (int f = 0; f < GC::BENCH_FRAMES; ++f)
+	{
+		topUp();
+		clock.restart();
+		shots.Update((f + 1) * GC::BENCH_DT);
+		updateTime += clock.restart().asSeconds();
+		CheckCollisions(game.objects, shots, game.grid, game.contacts);
+		collideTime += clock.restart().asSeconds();
+		numContacts += game.contacts.size();
+		gfx.Clear();
+		shots.Render(gfx);
+		renderTime += clock.restart().asSeconds();
+		game.EndFrame();
+	}
+
+	float perFrame = 1000.f / GC::BENCH_FRAMES;
+	out << "Projectiles, " << GC::BENCH_SHOTS << " bullets " << GC::BENCH_SHOOTERS << " enemies\n";
+	out << "  update " << updateTime * perFrame << "ms, collisions " << collideTime * perFrame << "ms, "
+		<< numContacts / GC::BENCH_FRAMES << " contacts, quads " << renderTime * perFrame << "ms per frame\n";
+	out << "  " << gfx.stats.drawCalls / GC::BENCH_FRAMES << " draw calls per frame, " << shots.numDropped << " dropped\n\n";
+}
+
+void BenchFlowField(ostream& out)
+{
+	srand(1);
+	const Vector2u area(GC::SCREEN_RES.x, GC::SCREEN_RES.y);
+	vector<float> radii(GC::NUM_ROCKS);
+	for (size_t i = 0; i < radii.size(); ++i)
+		radii[i] = GC::ROCK_RAD.x + (float)(rand() % (int)(GC::ROCK_RAD.y - GC::ROCK_RAD.x));
+	vector<Disk> none, disks;
+	PoissonDiskLayout(area, radii, GC::ROCK_MIN_DIST, none, disks, GC::PLACE_TRIES);
+	vector<GameObj> objects(disks.size());
+	for (size_t i = 0; i < disks.size(); ++i)
+	{
+		objects[i].active = true;
+		objects[i].type = GameObj::ObjectT::Rock;
+		objects[i].radius = disks[i].radius;
+		objects[i].spr.setPosition(disks[i].pos);
+	}
+	FlowField field;
+	field.Init(area);
+	auto randomPos = []() {
+		return Vector2f((float)(rand() % GC::SCREEN_RES.x), (float)(rand() % GC::SCREEN_RES.y));
+	};
+
+	//the player keeps changing cell, so every update is a full rebuild
+	Clock clock;
+	for (int i = 0; i < GC::BENCH_REBUILDS; ++i)
+		field.Update(objects, randomPos());
+	float rebuildTime = clock.restart().asSeconds() / max(field.numRebuilds, 1);
+	//the player stays put, only the rocks are checked
+	Vector2f player = randomPos();
+	field.Update(objects, player);
+	int rebuilds = field.numRebuilds;
+	clock.restart();
+	for (int i = 0; i < GC::BENCH_REBUILDS; ++i)
+		field.Update(objects, player);
+	float idleTime = clock.restart().asSeconds() / GC::BENCH_REBUILDS;
+	assert(field.numRebuilds == rebuilds);
+
+	out << "Flow field, " << field.cols << " x " << field.rows << " cells " << disks.size() << " rocks\n";
+	out << "  rebuild " << rebuildTime * 1e6f << "us, unchanged update " << idleTime * 1e6f << "us\n";
+	const int counts[]{ 1000, 10000, 100000 };
+	for (int n : counts)
+	{
+		vector<Vector2f> enemies(n);
+		for (int i = 0; i < n; ++i)
+			enemies[i] = randomPos();
+		Vector2f sum(0, 0);
+		clock.restart();
+		for (int i = 0; i < n; ++i)
+			sum += field.Steer(enemies[i]);
+		float secs = clock.restart().asSeconds();
+		out << "  " << n << " enemies steer in " << secs * 1e6f << "us, " << (secs * 1e9f) / n << "ns each"
+			<< ((sum.x == sum.x) ? "" : " NaN") << "\n";
+	}
+	out << "\n";
+}
+
+void BenchParallelCollisions(ostream& out)
+{
+	FrameArena arena;
+	arena.Init(GC::FRAME_ARENA_BYTES);
+	Projectiles noShots;
+	CollisionGrid grid;
+	out << "Parallel collisions, " << thread::hardware_concurrency() << " hardware threads\n";
+	const int counts[]{ 1000, 10000, 100000 };
+	for (int n : counts)
+	{
+		//spread them out as the count goes up so it's always about as crowded as the game
+		srand(1);
+		float spread = sqrtf(n / 1000.f);
+		vector<GameObj> objects(n);
+		for (int i = 0; i < n; ++i)
+		{
+			GameObj& obj = objects[i];
+			obj.active = true;
+			obj.type = (i % 2) ? GameObj::ObjectT::Enemy : GameObj::ObjectT::Rock;
+			obj.radius = GC::ROCK_RAD.x;
+			obj.spr.setPosition(spread * (rand() % GC::SCREEN_RES.x), spread * (rand() % GC::SCREEN_RES.y));
+		}
+		grid.Reserve(objects.size());
+
+		vector<Contact> expected;
+		float oneThread = 0;
+		for (int threads = 1; threads <= GC::BENCH_MAX_THREADS; threads *= 2)
+		{
+			WorkerPool workers;
+			workers.Init(threads);
+			ContactJobs jobs;
+			jobs.Init(workers.GetNumThreads() * GC::COLLIDE_JOBS_PER_THREAD, objects.size());
+			FrameVector<Contact> contacts{ FrameAlloc<Contact>(arena) };
+			//one untimed run to warm up, and to see roughly how many repeats fit in the time
+			Clock clock;
+			CheckCollisions(objects, noShots, grid, contacts, &workers, &jobs);
+			int repeats = max(1, (int)(GC::BENCH_COLLIDE_MS / max(clock.getElapsedTime().asSeconds() * 1000.f, 0.001f)));
+			clock.restart();
+			for (int r = 0; r < repeats; ++r)
+				CheckCollisions(objects, noShots, grid, contacts, &workers, &jobs);
+			float secs = clock.getElapsedTime().asSeconds() / repeats;
+
+			vector<Contact> found(contacts.begin(), contacts.end());
+			sort(found.begin(), found.end(), [](const Contact& lhs, const Contact& rhs) {
+				return (lhs.a == rhs.a) ? lhs.b < rhs.b : lhs.a < rhs.a;
+			});
+			FrameVector<Contact>(FrameAlloc<Contact>(arena)).swap(contacts);
+			arena.Reset();
+			bool same = true;
+			if (threads == 1)
+			{
+				expected.swap(found);
+				oneThread = secs;
+			}
+			else
+				same = found.size() == expected.size() && equal(found.begin(), found.end(), expected.begin(),
+					[](const Contact& lhs, const Contact& rhs) { return lhs.a == rhs.a && lhs.b == rhs.b; });
+			assert(same);
+
+			float speedup = (secs > 0) ? oneThread / secs : 0.f;
+			out << "  " << n << " objects " << threads << " threads: " << secs * 1000.f << "ms, "
+				<< expected.size() << " contacts, x" << speedup << " " << (int)(100.f * speedup / threads) << "% efficient"
+				<< (same ? "" : " CONTACTS DIFFER") << "\n";
+		}
+	}
+	out << "\n";
+}
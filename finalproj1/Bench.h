@@ -0,0 +1,62 @@
+#pragma once
+#include <ostream>
+
+#include "SFML/Graphics.hpp"
+
+struct Game;
+
+/*
+Timing tests for the hot spots in the game, run the game
+with -bench on the command line to get a report instead of playing
+out - where to write the results
+*/
+void RunBenchmarks(std::ostream& out);
+//every circle against every other, the original sqrtf test vs CircleToCircle vs CircleVsCircles8
+void BenchNarrowPhase(std::ostream& out);
+/*
+Fire lots of particle effects at once and see how many particles a second
+can be kept going, just the update, nothing is drawn
+*/
+void BenchEffects(std::ostream& out);
+/*
+Save and load a busy game (lots of objects, a full particle cache) to see
+how long snapshots take, and check a restored game carries on exactly the
+same with the whole game running. The scene is written to stress.bin so
+other tests can start from it
+*/
+void BenchSnapshot(std::ostream& out);
+//load stress.bin into a game set up like BenchSnapshot's and time whole game updates from there
+void BenchStressScene(std::ostream& out);
+//a headless game with BENCH_OBJECTS objects and a big particle cache, what the stress scene is saved from and loaded into
+void SetupStressGame(Game& game);
+//run the whole game on with no input, the particles too
+void StepStressGame(Game& game, int frames);
+/*
+Keep 50k enemy bullets in flight, fired in rings, and time the update,
+the broadphase and building the quads, nothing is rasterised
+*/
+void BenchProjectiles(std::ostream& out);
+/*
+Rocks laid out like a real game, then time rebuilding the flow field as the
+player jumps about, an update where nothing changed, and how long one enemy
+takes to steer with 1k to 100k enemies
+*/
+void BenchFlowField(std::ostream& out);
+/*
+CheckCollisions with 1k, 10k and 100k objects on 1 to 16 threads, checking
+every thread count finds exactly the same contacts. Efficiency is the
+speed up divided by the number of threads, 100% would be perfect scaling
+*/
+void BenchParallelCollisions(std::ostream& out);
+/*
+Visual regression test, run the game with -golden on the command line.
+A few set moments (intro, a second of play, game over) are drawn with the
+software renderer and compared to the images in golden/, a missing one
+is a failure. Add -update to save what's drawn as the new references
+No window is opened and the graphics card isn't used, textures are loaded
+as images and handed straight to the software renderer
+size - width and height to draw at
+update - save every image as the reference instead of checking it
+returns - false if any image didn't match or had no reference
+*/
+bool RunGoldenTests(const sf::Vector2u& size, std::ostream& out, bool update = false);
@@ -0,0 +1,182 @@
+#include <assert.h>
+#include <float.h>
+#include <algorithm>
+#ifdef __AVX__
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+#include "Collision.h"
+#include "GameObj.h"
+#include "Projectiles.h"
+
+using namespace sf;
+using namespace std;
+
+void CircleSoA::Resize(int n)
+{
+	num = n;
+	x.resize(n + GC::SIMD_WIDTH);
+	y.resize(n + GC::SIMD_WIDTH);
+	r.resize(n + GC::SIMD_WIDTH);
+	id.resize(n + GC::SIMD_WIDTH);
+	for (int i = n; i < n + GC::SIMD_WIDTH; ++i)
+		Set(i, GC::PAD_POS, GC::PAD_POS, 0, 0);
+}
+
+unsigned int CircleVsCircles8Scalar(float x, float y, float r, const float *xs, const float *ys, const float *rs)
+{
+	unsigned int hits = 0;
+	for (int i = 0; i < GC::SIMD_WIDTH; ++i)
+	{
+		float dx = xs[i] - x, dy = ys[i] - y, minDist = rs[i] + r;
+		if (dx * dx + dy * dy <= minDist * minDist)
+			hits |= 1u << i;
+	}
+	return hits;
+}
+
+#ifdef __AVX__
+unsigned int CircleVsCircles8(float x, float y, float r, const float *xs, const float *ys, const float *rs)
+{
+	__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs), _mm256_set1_ps(x));
+	__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys), _mm256_set1_ps(y));
+	__m256 minDist = _mm256_add_ps(_mm256_loadu_ps(rs), _mm256_set1_ps(r));
+	__m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+	return (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(dist2, _mm256_mul_ps(minDist, minDist), _CMP_LE_OQ));
+}
+#else
+unsigned int CircleVsCircles8(float x, float y, float r, const float *xs, const float *ys, const float *rs)
+{
+	//SSE is only 4 wide so do two halves
+	const __m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y), pr = _mm_set1_ps(r);
+	unsigned int hits = 0;
+	for (int h = 0; h < GC::SIMD_WIDTH; h += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + h), px);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + h), py);
+		__m128 minDist = _mm_add_ps(_mm_loadu_ps(rs + h), pr);
+		__m128 dist2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		hits |= (unsigned int)_mm_movemask_ps(_mm_cmple_ps(dist2, _mm_mul_ps(minDist, minDist))) << h;
+	}
+	return hits;
+}
+#endif
+
+void CollisionGrid::Reserve(size_t numObjects)
+{
+	//cells are never smaller than 1/MAX_GRID_CELLS of the area, so never more than MAX_GRID_CELLS+1 a side
+	const size_t maxSlots = (GC::MAX_GRID_CELLS + 1) * (GC::MAX_GRID_CELLS + 1) * NUM_LAYERS;
+	cellStart.reserve(maxSlots + 1);
+	cursor.reserve(maxSlots);
+	slotOf.reserve(numObjects);
+	circles.x.reserve(numObjects + GC::SIMD_WIDTH);
+	circles.y.reserve(numObjects + GC::SIMD_WIDTH);
+	circles.r.reserve(numObjects + GC::SIMD_WIDTH);
+	circles.id.reserve(numObjects + GC::SIMD_WIDTH);
+}
+
+void CollisionGrid::Build(const vector<GameObj>& objects, const Projectiles& shots)
+{
+	//how much space do the active objects and bullets cover and how big is the biggest?
+	float maxR = 0;
+	Vector2f minPos{ FLT_MAX,FLT_MAX }, maxPos{ -FLT_MAX,-FLT_MAX };
+	int numActive = 0;
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const GameObj& obj = objects[i];
+		if (obj.active)
+		{
+			const Vector2f& pos = obj.spr.getPosition();
+			minPos.x = min(minPos.x, pos.x);
+			minPos.y = min(minPos.y, pos.y);
+			maxPos.x = max(maxPos.x, pos.x);
+			maxPos.y = max(maxPos.y, pos.y);
+			maxR = max(maxR, obj.radius);
+			++numActive;
+		}
+	}
+	for (int i = 0; i < shots.num; ++i)
+	{
+		minPos.x = min(minPos.x, shots.x[i]);
+		minPos.y = min(minPos.y, shots.y[i]);
+		maxPos.x = max(maxPos.x, shots.x[i]);
+		maxPos.y = max(maxPos.y, shots.y[i]);
+	}
+	if (shots.num > 0)
+		maxR = max(maxR, GC::PROJECTILE_RADIUS);
+	numActive += shots.num;
+	if (numActive == 0)
+	{
+		cols = rows = 0;
+		cellStart.assign(1, 0);
+		circles.Resize(0);
+		return;
+	}
+
+	Vector2f size = maxPos - minPos;
+	cellSz = max(2.f * maxR, 1.f);
+	cellSz = max(cellSz, max(size.x, size.y) / GC::MAX_GRID_CELLS);
+	origin = minPos;
+	cols = (int)(size.x / cellSz) + 1;
+	rows = (int)(size.y / cellSz) + 1;
+	auto slotAt = [this](float x, float y, Layer layer) {
+		int cx = min(cols - 1, (int)((x - origin.x) / cellSz));
+		int cy = min(rows - 1, (int)((y - origin.y) / cellSz));
+		return SlotIdx(CellIdx(cx, cy), (int)layer);
+	};
+
+	//count how many go in each cell, then turn the counts into start positions
+	//bullets go after the objects in slotOf
+	const size_t numObjects = objects.size();
+	cellStart.assign(cols * rows * NUM_LAYERS + 1, 0);
+	slotOf.resize(numObjects + shots.num);
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		const GameObj& obj = objects[i];
+		slotOf[i] = -1;
+		if (obj.active)
+		{
+			const Vector2f& pos = obj.spr.getPosition();
+			slotOf[i] = slotAt(pos.x, pos.y, obj.GetLayer());
+			cellStart[slotOf[i] + 1]++;
+		}
+	}
+	for (int i = 0; i < shots.num; ++i)
+	{
+		int& slot = slotOf[numObjects + i];
+		slot = slotAt(shots.x[i], shots.y[i], (Layer)shots.faction[i]);
+		cellStart[slot + 1]++;
+	}
+	for (size_t c = 1; c < cellStart.size(); ++c)
+		cellStart[c] += cellStart[c - 1];
+
+	circles.Resize(numActive);
+	cursor.assign(cellStart.begin(), cellStart.end() - 1);
+	for (size_t i = 0; i < numObjects; ++i)
+		if (slotOf[i] >= 0)
+		{
+			const GameObj& obj = objects[i];
+			const Vector2f& pos = obj.spr.getPosition();
+			circles.Set(cursor[slotOf[i]]++, pos.x, pos.y, obj.radius, (unsigned int)i);
+		}
+	for (int i = 0; i < shots.num; ++i)
+		circles.Set(cursor[slotOf[numObjects + i]]++, shots.x[i], shots.y[i], GC::PROJECTILE_RADIUS, (unsigned int)(numObjects + i));
+}
+
+void CollisionGrid::SplitRows(int numBands, vector<int>& firstRow) const
+{
+	assert(numBands > 0);
+	firstRow.resize(numBands + 1);
+	int row = 0;
+	for (int b = 0; b < numBands; ++b)
+	{
+		//first row starting at or after this band's share of the circles
+		int target = (int)((long long)circles.num * b / numBands);
+		while (row < rows && RowStart(row) < target)
+			++row;
+		firstRow[b] = row;
+	}
+	firstRow[numBands] = rows;
+}
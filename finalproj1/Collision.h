@@ -0,0 +1,202 @@
+#pragma once
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+struct GameObj;
+struct Projectiles;
+
+namespace GC
+{
+	const int SIMD_WIDTH = 8;			//circles tested at once by CircleVsCircles8
+	const float PAD_POS = 1e18f;		//where padding circles live, far enough away to never touch anything
+	const int MAX_GRID_CELLS = 256;		//per side, the cells grow if the objects are spread further than this
+}
+
+//which group a collision circle is in, bullets are split by who fired them
+enum class Layer { Player, PlayerBullet, EnemyBullet, Rock, Enemy, COUNT };
+const int NUM_LAYERS = (int)Layer::COUNT;
+
+/*
+Which layers can hit each other, anything not ticked is never even distance
+tested. Must be symmetric. Bullets don't hit bullets or whoever fired them,
+rocks don't hit rocks and enemies don't hit enemies
+*/
+constexpr bool LAYER_MATRIX[NUM_LAYERS][NUM_LAYERS]{
+	//Player PlayerBullet EnemyBullet Rock   Enemy
+	{ false, false,       true,       true,  true  },	//Player
+	{ false, false,       false,      true,  true  },	//PlayerBullet
+	{ true,  false,       false,      true,  false },	//EnemyBullet
+	{ true,  true,        true,       false, true  },	//Rock
+	{ true,  true,        false,      true,  false },	//Enemy
+};
+
+constexpr unsigned int LayerBit(Layer layer) {
+	return 1u << (int)layer;
+}
+//every layer this one interacts with, one bit each
+constexpr unsigned int LayerMask(Layer layer) {
+	unsigned int mask = 0;
+	for (int i = 0; i < NUM_LAYERS; ++i)
+		if (LAYER_MATRIX[(int)layer][i])
+			mask |= 1u << i;
+	return mask;
+}
+constexpr bool IsLayerMatrixSymmetric() {
+	for (int a = 0; a < NUM_LAYERS; ++a)
+		for (int b = 0; b < NUM_LAYERS; ++b)
+			if (LAYER_MATRIX[a][b] != LAYER_MATRIX[b][a])
+				return false;
+	return true;
+}
+static_assert(IsLayerMatrixSymmetric(), "LAYER_MATRIX must be symmetric, a hitting b means b hits a");
+
+/*
+Circles packed into separate x, y and radius arrays so the narrow phase
+can load 8 of them at once. There are always SIMD_WIDTH padding circles
+on the end so a test that runs off the end of a range is still safe
+*/
+struct CircleSoA {
+	std::vector<float> x, y, r;		//centres and radii
+	std::vector<unsigned int> id;	//which object each circle came from
+	int num = 0;					//real circles, not counting the padding
+
+	//make room for n circles plus the padding, keeps the memory if it's shrinking
+	void Resize(int n);
+	void Set(int i, float px, float py, float pr, unsigned int objId) {
+		x[i] = px;
+		y[i] = py;
+		r[i] = pr;
+		id[i] = objId;
+	}
+};
+
+/*
+Test one circle against 8 packed circles using squared distances
+x,y,r - the circle to test
+xs,ys,rs - the first of 8 circles to test it against, no alignment needed
+returns - bit n is set if circle n is touching
+*/
+unsigned int CircleVsCircles8(float x, float y, float r, const float *xs, const float *ys, const float *rs);
+//same thing, one circle at a time, to check against and benchmark with
+unsigned int CircleVsCircles8Scalar(float x, float y, float r, const float *xs, const float *ys, const float *rs);
+/*
+Test one circle against a run of packed circles, 8 at a time
+first,last - the range of circles in soa to test against
+fn - called with the index (in soa) of each circle it touches
+*/
+template<typename FN>
+void CircleVsRange(float x, float y, float r, const CircleSoA& soa, int first, int last, FN fn)
+{
+	for (int i = first; i < last; i += GC::SIMD_WIDTH)
+	{
+		unsigned int hits = CircleVsCircles8(x, y, r, &soa.x[i], &soa.y[i], &soa.r[i]);
+		if (last - i < GC::SIMD_WIDTH)
+			hits &= (1u << (last - i)) - 1;
+		while (hits)
+		{
+			int bit = 0;
+			while (!(hits & (1u << bit)))
+				++bit;
+			hits &= ~(1u << bit);
+			fn(i + bit);
+		}
+	}
+}
+
+/*
+Uniform grid broadphase. Active objects are binned by their centre and packed
+into a CircleSoA in cell order, so every cell is one contiguous run of circles,
+sorted by layer inside the cell. Cells are at least as big as the widest object,
+so anything an object can touch is in its own cell or one of the eight around it,
+and only the runs of layers it interacts with are tested
+*/
+struct CollisionGrid {
+	float cellSz = 1;				//width and height of a cell
+	sf::Vector2f origin;			//top left of cell 0,0
+	int cols = 0, rows = 0;
+	std::vector<int> cellStart;		//index into circles of the first circle of each cell and layer (see SlotIdx), one extra on the end
+	std::vector<int> slotOf;		//scratch, which cell and layer each object went in, -1 if inactive
+	std::vector<int> cursor;		//scratch, next free place in each cell and layer while packing
+	CircleSoA circles;				//every active object, in cell order
+
+	//make room up front for the biggest grid there can be, so Build never has to allocate
+	void Reserve(size_t numObjects);
+	//bin all the active objects and every bullet, a bullet's id is objects.size() + its index
+	void Build(const std::vector<GameObj>& objects, const Projectiles& shots);
+	int CellIdx(int cx, int cy) const {
+		return cy * cols + cx;
+	}
+	//where a cell's run of one layer starts in cellStart
+	int SlotIdx(int cell, int layer) const {
+		return cell * NUM_LAYERS + layer;
+	}
+	bool CellEmpty(int cell) const {
+		return cellStart[SlotIdx(cell, 0)] == cellStart[SlotIdx(cell + 1, 0)];
+	}
+	//index in circles of the first circle in a row of cells, rows gives the end of the last row
+	int RowStart(int row) const {
+		return cellStart[SlotIdx(CellIdx(0, row), 0)];
+	}
+	/*
+	Cut the rows into bands with about the same number of circles in each,
+	so the bands can be searched on different threads
+	numBands - how many
+	firstRow - filled with the first row of each band, one extra on the end holding rows
+	*/
+	void SplitRows(int numBands, std::vector<int>& firstRow) const;
+	/*
+	Find every touching pair, each pair is reported once
+	fn - called with the two object ids
+	*/
+	template<typename FN>
+	void FindPairs(FN fn) const
+	{
+		FindPairsInRows(0, rows, fn);
+	}
+	/*
+	Same, but only the pairs found from cells in rows [firstRow,lastRow). Every
+	pair belongs to exactly one cell, so bands of rows that don't overlap never
+	report the same pair and can be searched at the same time
+	*/
+	template<typename FN>
+	void FindPairsInRows(int firstRow, int lastRow, FN fn) const
+	{
+		//only look forward (right and down) so a pair between two cells is only found once
+		const int NEIGHBOURS[4][2]{ { 1,0 },{ -1,1 },{ 0,1 },{ 1,1 } };
+		for (int cy = firstRow; cy < lastRow; ++cy)
+			for (int cx = 0; cx < cols; ++cx)
+			{
+				int c = CellIdx(cx, cy);
+				for (int layer = 0; layer < NUM_LAYERS; ++layer)
+				{
+					const unsigned int mask = LayerMask((Layer)layer);
+					for (int i = cellStart[SlotIdx(c, layer)]; i < cellStart[SlotIdx(c, layer + 1)]; ++i)
+					{
+						float x = circles.x[i], y = circles.y[i], r = circles.r[i];
+						unsigned int idA = circles.id[i];
+						auto report = [&](int j) { fn(idA, circles.id[j]); };
+						for (int other = 0; other < NUM_LAYERS; ++other)
+						{
+							if (!(mask & (1u << other)))
+								continue;
+							//inside our own cell a pair of layers is only done from the lower one
+							if (other == layer)
+								CircleVsRange(x, y, r, circles, i + 1, cellStart[SlotIdx(c, other + 1)], report);
+							else if (other > layer)
+								CircleVsRange(x, y, r, circles, cellStart[SlotIdx(c, other)], cellStart[SlotIdx(c, other + 1)], report);
+							for (int n = 0; n < 4; ++n)
+							{
+								int nx = cx + NEIGHBOURS[n][0], ny = cy + NEIGHBOURS[n][1];
+								if (nx >= 0 && nx < cols && ny < rows)
+								{
+									int nc = CellIdx(nx, ny);
+									CircleVsRange(x, y, r, circles, cellStart[SlotIdx(nc, other)], cellStart[SlotIdx(nc, other + 1)], report);
+								}
+							}
+						}
+					}
+				}
+			}
+	}
+};
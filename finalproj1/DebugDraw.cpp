@@ -0,0 +1,47 @@
+#include <math.h>
+
+#include "DebugDraw.h"
+
+using namespace sf;
+using namespace std;
+
+void DebugDraw::Line(const Vector2f& from, const Vector2f& to, Color col)
+{
+	lines.append(Vertex(from, col));
+	lines.append(Vertex(to, col));
+}
+
+void DebugDraw::Box(const FloatRect& r, Color col)
+{
+	Vector2f tl(r.left, r.top), tr(r.left + r.width, r.top);
+	Vector2f bl(r.left, r.top + r.height), br(r.left + r.width, r.top + r.height);
+	Line(tl, tr, col);
+	Line(tr, br, col);
+	Line(br, bl, col);
+	Line(bl, tl, col);
+}
+
+void DebugDraw::Circle(const Vector2f& pos, float radius, Color col)
+{
+	if (unitCircle.empty())
+	{
+		for (int i = 0; i < CIRCLE_POINTS; ++i)
+		{
+			float angle = (6.2831853f * i) / CIRCLE_POINTS;
+			unitCircle.push_back(Vector2f(cosf(angle), sinf(angle)));
+		}
+	}
+	for (int i = 0; i < CIRCLE_POINTS; ++i)
+	{
+		const Vector2f& a = unitCircle[i];
+		const Vector2f& b = unitCircle[(i + 1) % CIRCLE_POINTS];
+		Line(pos + a * radius, pos + b * radius, col);
+	}
+}
+
+void DebugDraw::Render(RenderBackend& gfx)
+{
+	if (lines.getVertexCount() > 0)
+		gfx.Draw(lines);
+	lines.clear();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+#include "RenderBackend.h"
+
+/*
+Collects debug shapes (collision circles, grid cells, etc) as lines
+over the frame and draws them all with one draw call at the end.
+Nothing in here knows about collisions, anything can queue shapes
+*/
+struct DebugDraw {
+	const int CIRCLE_POINTS = 20;		//line segments per circle
+	sf::VertexArray lines{ sf::Lines };	//everything queued this frame, two vertices per line
+	std::vector<sf::Vector2f> unitCircle;	//CIRCLE_POINTS points around a circle of radius 1
+
+	void Line(const sf::Vector2f& from, const sf::Vector2f& to, sf::Color col);
+	void Box(const sf::FloatRect& r, sf::Color col);
+	void Circle(const sf::Vector2f& pos, float radius, sf::Color col);
+	//draw everything queued so far in one go, then empty the queue
+	void Render(RenderBackend& gfx);
+	//forget everything queued without drawing it
+	void Clear() {
+		lines.clear();
+	}
+};
@@ -0,0 +1,62 @@
+#include <assert.h>
+
+#include "DynamicRes.h"
+
+using namespace sf;
+using namespace std;
+
+void DynamicRes::Resize(const Vector2u& windowSz)
+{
+	if (size == windowSz)
+		return;
+	if (!target.create(windowSz.x, windowSz.y))
+		assert(false);
+	target.setSmooth(true);
+	size = windowSz;
+}
+
+RenderBackend& DynamicRes::Begin(const Vector2u& windowSz)
+{
+	Resize(windowSz);
+	//the view still covers the whole window, it's just squeezed into a corner of the target
+	const float scale = GetScale();
+	View view(FloatRect(0, 0, (float)size.x, (float)size.y));
+	view.setViewport(FloatRect(0, 0, scale, scale));
+	target.setView(view);
+	gfx.stats.Reset();
+	gfx.Clear();
+	return gfx;
+}
+
+void DynamicRes::End(RenderBackend& window)
+{
+	target.display();
+	const float scale = GetScale();
+	IntRect used(0, 0, (int)(size.x * scale + 0.5f), (int)(size.y * scale + 0.5f));
+	spr.setTexture(target.getTexture());
+	spr.setTextureRect(used);
+	spr.setScale(size.x / (float)used.width, size.y / (float)used.height);
+	window.Draw(spr);
+}
+
+void DynamicRes::AddFrame(float workT)
+{
+	avgWork = (avgWork == 0) ? workT : avgWork + (workT - avgWork) * GC::RES_SMOOTHING;
+	if (hold > 0)
+	{
+		--hold;
+		return;
+	}
+	if (avgWork > budget * GC::RES_DROP && level < GC::NUM_RES_SCALES - 1)
+	{
+		++level;
+		++numDrops;
+		hold = GC::RES_HOLD_FRAMES;
+	}
+	else if (avgWork < budget * GC::RES_RAISE && level > 0)
+	{
+		--level;
+		++numRaises;
+		hold = GC::RES_HOLD_FRAMES;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "SFML/Graphics.hpp"
+#include "RenderBackend.h"
+
+namespace GC
+{
+	const float RES_SCALES[] = { 1.f, 0.85f, 0.7f, 0.5f };	//fractions of the window resolution the world can be drawn at
+	const int NUM_RES_SCALES = sizeof(RES_SCALES) / sizeof(RES_SCALES[0]);
+	const float RES_DROP = 0.9f;		//go down a scale when frames take more than this much of the budget
+	const float RES_RAISE = 0.6f;		//go back up when they take less than this much
+	const float RES_SMOOTHING = 0.1f;	//how much each new frame time counts towards the average
+	const int RES_HOLD_FRAMES = 30;		//frames to leave it alone after a change so the average can catch up
+}
+
+/*
+Draws the world into an off screen target that can be smaller than the
+window, then stretches it to fit. The target is always window sized, a
+smaller scale just draws into its top left corner, so changing scale never
+allocates. Which scale to use comes from how long frames are taking against
+the budget, dropping quickly when they're slow (explosions) and only coming
+back up once there's plenty of time to spare
+*/
+struct DynamicRes {
+	sf::RenderTexture target;
+	SFMLBackend gfx{ target };		//draws into target
+	sf::Sprite spr;					//the used part of target, stretched over the window
+	sf::Vector2u size;				//window size target was made for
+	int level = 0;					//into GC::RES_SCALES
+	float budget = 1.f / 60.f;		//seconds a frame should take
+	float avgWork = 0;				//smoothed seconds of work per frame, not counting any waiting
+	int hold = 0;					//frames until it can change scale again
+	int numDrops = 0, numRaises = 0;
+
+	//frameBudget - seconds a frame should take
+	void Init(float frameBudget) {
+		budget = frameBudget;
+		level = 0;
+		avgWork = 0;
+		hold = 0;
+	}
+	float GetScale() const {
+		return GC::RES_SCALES[level];
+	}
+	/*
+	Make the target for a new window size, does nothing if it's the same.
+	Call it as soon as the window changes, Begin only does it itself as a
+	fallback and then it's in the middle of a frame
+	*/
+	void Resize(const sf::Vector2u& windowSz);
+	/*
+	Get ready to draw the world, positions are still in window pixels
+	windowSz - the target is remade if this changes and Resize wasn't called
+	returns - somewhere to draw the world
+	*/
+	RenderBackend& Begin(const sf::Vector2u& windowSz);
+	//stretch what was drawn over the whole window
+	void End(RenderBackend& window);
+	/*
+	Pick the scale for the next frame
+	workT - seconds this frame spent updating, drawing and displaying
+	*/
+	void AddFrame(float workT);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+//every kind of particle effect in the game, indexes EFFECT_PRESETS
+enum class EffectT { EnemySplash, BulletSplash, RockExplode, ShipExplode, COUNT };
+
+/*
+Everything needed to set up an Emitter for one kind of effect
+Plain numbers only so a table of them can be built at compile time
+*/
+struct EffectPreset {
+	const char *name;		//used to match up entries in data/effects.txt
+	int numToEmit;			//particles in total
+	int numAtOnce;			//particles per burst
+	float rate;				//seconds between bursts
+	int r, g, b, a;			//particle tint
+	float scaleX, scaleY;	//particle sprite scale
+	float life;				//seconds each particle lives
+	int speedMin, speedMax;	//random speed range
+	int sizeSpeedMin, sizeSpeedMax;	//added to the speed range, scaled by the size of whatever caused it
+	bool useInitVel;		//does the effect drift with the thing that caused it
+};
+
+//the built in effects, data/effects.txt can override any of them by name
+constexpr EffectPreset EFFECT_PRESETS[(int)EffectT::COUNT]{
+	//name			total	burst	rate	r	g	b	a	scale		life	speed		size speed	drift
+	{ "enemy_splash",	500,	10,	0.001f,	90,	20,	20,	255,	0.25f, 0.25f,	0.75f,	50, 75,		0, 0,		false },
+	{ "bullet_splash",	30,	30,	0.001f,	128,	50,	50,	255,	0.15f, 0.15f,	0.25f,	15, 20,		0, 0,		true },
+	{ "rock_explode",	500,	20,	0.001f,	10,	10,	19,	255,	0.5f, 0.5f,	1.f,	12, 25,		25, 50,		false },
+	{ "ship_explode",	1000,	50,	0.001f,	10,	20,	20,	255,	0.5f, 0.75f,	1.f,	50, 350,	0, 0,		true },
+};
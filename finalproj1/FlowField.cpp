@@ -0,0 +1,144 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+#include "FlowField.h"
+#include "GameObj.h"
+
+using namespace sf;
+using namespace std;
+
+const unsigned short FlowField::UNREACHED;
+
+void FlowField::Init(const Vector2u& area, float cell)
+{
+	assert(cell > 0);
+	cellSz = cell;
+	cols = max(1, (int)ceilf(area.x / cell));
+	rows = max(1, (int)ceilf(area.y / cell));
+	const size_t num = (size_t)cols * rows;
+	blocked.assign(num, 0);
+	newBlocked.assign(num, 0);
+	dist.assign(num, UNREACHED);
+	dirX.assign(num, 0.f);
+	dirY.assign(num, 0.f);
+	queue.resize(num);
+	goalCell = -1;
+}
+
+int FlowField::CellAt(const Vector2f& pos) const
+{
+	int x = min(max((int)floorf(pos.x / cellSz), 0), cols - 1);
+	int y = min(max((int)floorf(pos.y / cellSz), 0), rows - 1);
+	return y * cols + x;
+}
+
+bool FlowField::Update(const vector<GameObj>& objects, const Vector2f& target)
+{
+	assert(cols > 0);
+	//mark every cell a rock (plus clearance) reaches into
+	fill(newBlocked.begin(), newBlocked.end(), (unsigned char)0);
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const GameObj& obj = objects[i];
+		if (!obj.active || obj.type != GameObj::ObjectT::Rock)
+			continue;
+		const Vector2f& pos = obj.spr.getPosition();
+		const float r = obj.radius + GC::FLOW_CLEARANCE;
+		int x0 = max((int)floorf((pos.x - r) / cellSz), 0), x1 = min((int)floorf((pos.x + r) / cellSz), cols - 1);
+		int y0 = max((int)floorf((pos.y - r) / cellSz), 0), y1 = min((int)floorf((pos.y + r) / cellSz), rows - 1);
+		for (int y = y0; y <= y1; ++y)
+			for (int x = x0; x <= x1; ++x)
+			{
+				//closest point in the cell to the rock's centre
+				float dx = pos.x - min(max(pos.x, x * cellSz), (x + 1) * cellSz);
+				float dy = pos.y - min(max(pos.y, y * cellSz), (y + 1) * cellSz);
+				if (dx * dx + dy * dy <= r * r)
+					newBlocked[y * cols + x] = 1;
+			}
+	}
+
+	goal = target;
+	int cell = CellAt(target);
+	bool rocksMoved = newBlocked != blocked;
+	if (rocksMoved)
+		blocked.swap(newBlocked);
+	if (!rocksMoved && cell == goalCell)
+		return false;
+	goalCell = cell;
+	Rebuild();
+	return true;
+}
+
+void FlowField::Rebuild()
+{
+	assert(goalCell >= 0 && goalCell < (int)dist.size());
+	++numRebuilds;
+	fill(dist.begin(), dist.end(), UNREACHED);
+
+	//breadth first out from the player, four neighbours so paths can't squeeze between diagonal rocks
+	int head = 0, tail = 0;
+	dist[goalCell] = 0;
+	queue[tail++] = goalCell;
+	const int offX[4]{ 1, -1, 0, 0 }, offY[4]{ 0, 0, 1, -1 };
+	while (head < tail)
+	{
+		int c = queue[head++];
+		int cx = c % cols, cy = c / cols;
+		unsigned short d = dist[c] + 1;
+		for (int i = 0; i < 4; ++i)
+		{
+			int nx = cx + offX[i], ny = cy + offY[i];
+			if (nx < 0 || nx >= cols || ny < 0 || ny >= rows)
+				continue;
+			int n = ny * cols + nx;
+			if (blocked[n] || dist[n] != UNREACHED)
+				continue;
+			dist[n] = d;
+			queue[tail++] = n;
+		}
+	}
+
+	//point each cell at its lowest neighbour, diagonals only if both cells beside them are open
+	const float DIAG = 0.70710678f;
+	for (int cy = 0; cy < rows; ++cy)
+		for (int cx = 0; cx < cols; ++cx)
+		{
+			int c = cy * cols + cx;
+			dirX[c] = dirY[c] = 0;
+			if (dist[c] == UNREACHED || dist[c] == 0)
+				continue;
+			unsigned short best = dist[c];
+			int bx = 0, by = 0;
+			for (int dy = -1; dy <= 1; ++dy)
+				for (int dx = -1; dx <= 1; ++dx)
+				{
+					int nx = cx + dx, ny = cy + dy;
+					if ((dx == 0 && dy == 0) || nx < 0 || nx >= cols || ny < 0 || ny >= rows)
+						continue;
+					if (dist[ny * cols + nx] >= best)
+						continue;
+					if (dx != 0 && dy != 0 && (blocked[cy * cols + nx] || blocked[ny * cols + cx]))
+						continue;
+					best = dist[ny * cols + nx];
+					bx = dx;
+					by = dy;
+				}
+			float len = (bx != 0 && by != 0) ? DIAG : 1.f;
+			dirX[c] = bx * len;
+			dirY[c] = by * len;
+		}
+}
+
+Vector2f FlowField::Steer(const Vector2f& pos) const
+{
+	if (goalCell >= 0)
+	{
+		int c = CellAt(pos);
+		if (c != goalCell && (dirX[c] != 0 || dirY[c] != 0))
+			return Vector2f(dirX[c], dirY[c]);
+	}
+	Vector2f d = goal - pos;
+	float len = sqrtf(d.x * d.x + d.y * d.y);
+	return (len > 0) ? d / len : Vector2f(0, 0);
+}
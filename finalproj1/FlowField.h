@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+struct GameObj;
+
+namespace GC
+{
+	const float FLOW_CELL = 32.f;		//width and height of a flow field cell
+	const float FLOW_CLEARANCE = 12.f;	//how far off a rock a cell has to be to be walkable
+}
+
+/*
+One shared map of the way to the player, so any number of enemies can chase
+them for the price of one lookup each instead of each finding its own path.
+The screen is cut into cells, cells with a rock in them are blocked, and a
+breadth first search out from the player's cell gives every other cell its
+distance in steps. Each cell then stores a unit vector towards its lowest
+neighbour. Nothing is rebuilt until the player moves into another cell or
+the rocks change, which most frames they don't
+*/
+struct FlowField {
+	static const unsigned short UNREACHED = 0xFFFF;	//walled off from the player, or blocked
+
+	int cols = 0, rows = 0;
+	float cellSz = GC::FLOW_CELL;
+	std::vector<unsigned char> blocked;		//1 if a rock covers the cell
+	std::vector<unsigned char> newBlocked;	//scratch, compared against blocked to see if anything moved
+	std::vector<unsigned short> dist;		//steps to the player's cell
+	std::vector<float> dirX, dirY;			//which way to go from each cell, zero if there's no way
+	std::vector<int> queue;					//search frontier, sized once by Init
+	sf::Vector2f goal;						//where the player is
+	int goalCell = -1;						//cell the field was built for, -1 forces a rebuild
+	int numRebuilds = 0;					//how many times the search has been run
+
+	/*
+	area - size of the play area in pixels
+	cell - width and height of each cell
+	*/
+	void Init(const sf::Vector2u& area, float cell = GC::FLOW_CELL);
+	//throw the field away so the next Update builds it again, e.g. after loading a snapshot
+	void Clear() {
+		goalCell = -1;
+	}
+	/*
+	Once a frame, before the enemies move
+	objects - active rocks are obstacles
+	target - where the enemies are heading
+	returns - true if the field had to be rebuilt
+	*/
+	bool Update(const std::vector<GameObj>& objects, const sf::Vector2f& target);
+	//the search, fills dist then dirX/dirY from the current blocked cells and goalCell
+	void Rebuild();
+	//cell under a point, anything off the edge gets the nearest edge cell
+	int CellAt(const sf::Vector2f& pos) const;
+	/*
+	Which way to head from here, safe to call from many threads at once
+	pos - where the enemy is
+	returns - a unit vector, straight at the target once in its cell or if there's no path
+	*/
+	sf::Vector2f Steer(const sf::Vector2f& pos) const;
+};
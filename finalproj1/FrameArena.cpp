@@ -0,0 +1,74 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <new>
+#include <algorithm>
+
+#include "FrameArena.h"
+
+using namespace std;
+
+void FrameArena::Init(size_t bytes)
+{
+	block.resize(bytes);
+	used = 0;
+	overflows = 0;
+}
+
+void* FrameArena::Alloc(size_t bytes, size_t align)
+{
+	assert(align > 0 && (align & (align - 1)) == 0 && align <= alignof(max_align_t));
+	size_t start = (used + align - 1) & ~(align - 1);
+	if (start + bytes > block.size())
+	{
+		++overflows;
+		return ::operator new(bytes);
+	}
+	used = start + bytes;
+	return block.data() + start;
+}
+
+void FrameArena::Free(void *p)
+{
+	if (p && !Owns(p))
+		::operator delete(p);
+}
+
+void FrameArena::Reset()
+{
+	peak = max(peak, used);
+	used = 0;
+	overflows = 0;
+}
+
+#ifdef _DEBUG
+//replace the global new/delete just to count, array and nothrow versions come through these too
+static thread_local long long tHeapAllocs = 0;
+
+void* operator new(size_t bytes)
+{
+	++tHeapAllocs;
+	if (void *p = malloc(bytes ? bytes : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+long long HeapAllocCount()
+{
+	return tHeapAllocs;
+}
+#else
+long long HeapAllocCount()
+{
+	return 0;
+}
+#endif
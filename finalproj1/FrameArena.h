@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/*
+Memory for things that only live for one frame. Allocating just moves a
+pointer along and nothing is given back until Reset at the end of the frame,
+when everything goes at once. If a frame needs more than there is, the extra
+comes from the heap and is counted in overflows so it can be made bigger
+*/
+struct FrameArena {
+	std::vector<char> block;	//all the memory, allocated once by Init
+	size_t used = 0;			//bytes handed out this frame
+	size_t peak = 0;			//most bytes used in any frame so far
+	int overflows = 0;			//allocations this frame that didn't fit and went to the heap
+
+	void Init(size_t bytes);
+	/*
+	bytes - how much memory
+	align - must be a power of two, no bigger than the heap's own alignment
+	*/
+	void* Alloc(size_t bytes, size_t align = alignof(std::max_align_t));
+	//only heap overflows are really given back, arena memory waits for Reset
+	void Free(void *p);
+	bool Owns(const void *p) const {
+		return !block.empty() && p >= block.data() && p < block.data() + block.size();
+	}
+	//end of the frame, anything allocated from the arena must not be used after this
+	void Reset();
+};
+
+/*
+Lets STL containers allocate from a FrameArena, e.g. FrameVector<int> v{ FrameAlloc<int>(arena) };
+Containers using it must be emptied or thrown away before the arena is Reset
+*/
+template<typename T>
+struct FrameAlloc {
+	typedef T value_type;
+	FrameArena *pArena;
+
+	FrameAlloc(FrameArena& arena) : pArena(&arena) {}
+	template<typename U>
+	FrameAlloc(const FrameAlloc<U>& other) : pArena(other.pArena) {}
+	T* allocate(size_t n) {
+		return static_cast<T*>(pArena->Alloc(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T *p, size_t) {
+		pArena->Free(p);
+	}
+};
+template<typename T, typename U>
+bool operator==(const FrameAlloc<T>& lhs, const FrameAlloc<U>& rhs) {
+	return lhs.pArena == rhs.pArena;
+}
+template<typename T, typename U>
+bool operator!=(const FrameAlloc<T>& lhs, const FrameAlloc<U>& rhs) {
+	return lhs.pArena != rhs.pArena;
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAlloc<T>>;
+typedef std::basic_string<char, std::char_traits<char>, FrameAlloc<char>> FrameString;
+
+/*
+How many times the global operator new has been called by this thread,
+so e.g. the render thread's allocations don't count against the simulation.
+Only counted in debug builds, in release it's always 0
+*/
+long long HeapAllocCount();
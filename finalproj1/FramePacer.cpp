@@ -0,0 +1,52 @@
+#include <thread>
+#include <algorithm>
+
+#include "FramePacer.h"
+
+using namespace sf;
+using namespace std;
+
+void FramePacer::Init(float fps)
+{
+	period = (fps > 0) ? seconds(1.f / fps) : Time::Zero;
+	spinMargin = GC::MIN_SPIN;
+	sleepError = 0;
+	numLate = 0;
+	clock.restart();
+	deadline = Time::Zero;
+}
+
+void FramePacer::Wait()
+{
+	if (period == Time::Zero)
+		return;
+	deadline += period;
+	Time now = clock.getElapsedTime();
+	if (now >= deadline)
+	{
+		//too slow to keep up, don't try to catch up by rushing the next few frames
+		++numLate;
+		deadline = now;
+		return;
+	}
+
+	Time toSleep = deadline - now - seconds(spinMargin);
+	sleepError *= GC::SLEEP_ERROR_DECAY;
+	if (toSleep > Time::Zero)
+	{
+		sleep(toSleep);
+		float over = (clock.getElapsedTime() - now - toSleep).asSeconds();
+		sleepError = max(sleepError, over);
+	}
+	//spin for a little longer than sleeps have been overshooting by
+	spinMargin = min(max(sleepError * 1.5f, GC::MIN_SPIN), GC::MAX_SPIN);
+	while (clock.getElapsedTime() < deadline)
+		this_thread::yield();
+}
+
+void WaitForInput(RenderWindow& window, InputState& input)
+{
+	Event event;
+	if (window.waitEvent(event))
+		input.Handle(event);
+}
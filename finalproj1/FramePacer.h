@@ -0,0 +1,43 @@
+#pragma once
+#include "SFML/Graphics.hpp"
+#include "Input.h"
+
+namespace GC
+{
+	const float TARGET_FPS = 60.f;		//frame limit, -fps on the command line changes it, 0 means no limit
+	const float MIN_SPIN = 0.0005f;		//always spin at least this long at the end of a wait, sleeps are never exact
+	const float MAX_SPIN = 0.004f;		//never spin longer than this, however badly sleeps overshoot
+	const float SLEEP_ERROR_DECAY = 0.99f;	//per frame, so one bad oversleep is forgotten after a few seconds
+}
+
+/*
+Holds each frame back until its turn so the game runs at a steady rate
+instead of spinning a core flat out. Most of the wait is a sleep, which the
+OS can wake late, so the last bit before the deadline is a spin. How long
+that spin is adapts to how late sleeps have actually been waking up
+*/
+struct FramePacer {
+	sf::Time period;				//one frame, zero means don't wait at all
+	sf::Time deadline;				//when the next frame should start, on clock
+	sf::Clock clock;
+	float spinMargin = GC::MIN_SPIN;	//seconds before the deadline to stop sleeping
+	float sleepError = 0;			//worst recent oversleep in seconds, fades away a little each frame
+	int numLate = 0;				//frames that were already past their deadline
+
+	//fps - frames a second to aim for, 0 or less for no limit
+	void Init(float fps);
+	//wait until the next frame is due, if this frame ran late the schedule restarts from now
+	void Wait();
+	//forget the schedule, e.g. after sitting in WaitForInput, the next frame is due now
+	void Restart() {
+		deadline = clock.getElapsedTime();
+	}
+};
+
+/*
+Sleep until the window has an event rather than polling, for screens where
+nothing changes unless the player does something
+window - where the events come from
+input - the event is passed on to this, InputState::changed says if it matters
+*/
+void WaitForInput(sf::RenderWindow& window, InputState& input);
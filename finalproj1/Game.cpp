@@ -4,6 +4,7 @@
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <algorithm>
 
 #include "Game.h"
 
@@ -12,6 +13,8 @@ using namespace std;
 
 void Metrics::SortAndUpdatePlayerData() {
 	PlayerData d{ name,score };
+	d.perf = telemetry.SessionSummary();
+	d.cores = (int)thread::hardware_concurrency();
 	playerData.push_back(d);
 }
 
@@ -32,7 +35,10 @@ bool Metrics::FileSave(const std::string& path) {
 		fs << VERSION;
 		for (size_t i = 0; i < playerData.size(); ++i)
 		{
-			fs << ' ' << playerData[i].name << ' ' << playerData[i].score;
+			const PlayerData& d = playerData[i];
+			fs << ' ' << d.name << ' ' << d.score;
+			fs << ' ' << d.perf.frames << ' ' << d.perf.p50 << ' ' << d.perf.p95 << ' ' << d.perf.p99
+				<< ' ' << d.perf.max << ' ' << d.perf.overBudget << ' ' << d.cores;
 		}
 		assert(!fs.fail());
 		fs.close();
@@ -60,7 +66,9 @@ bool Metrics::FileLoad(const std::string& path) {
 	{
 		string version;
 		fs >> version;
-		if (version == VERSION)
+		//older files just have the name and score, their perf figures are left empty
+		const bool withPerf = version == VERSION;
+		if (withPerf || version == VERSION_NO_PERF)
 		{
 			playerData.clear();
 			while (!fs.eof()) {
@@ -69,6 +77,8 @@ bool Metrics::FileLoad(const std::string& path) {
 				assert(!d.name.empty());
 				fs >> d.score;
 				assert(d.score >= 0);
+				if (withPerf)
+					fs >> d.perf.frames >> d.perf.p50 >> d.perf.p95 >> d.perf.p99 >> d.perf.max >> d.perf.overBudget >> d.cores;
 				playerData.push_back(d);
 			}
 		}
@@ -87,6 +97,7 @@ bool Metrics::IsScoreInTopTen() {
 void Metrics::Restart() {
 	score = 0;
 	lives = GC::NUM_LIVES;
+	telemetry.StartSession();
 }
 
 
@@ -110,130 +121,190 @@ bool LoadTexture(const string& file, Texture& tex)
 }
 
 
-void DrawCircle(RenderWindow& window, const Vector2f& pos, float radius, Color col)
-{
-	CircleShape c;
-	c.setRadius(radius);
-	c.setPointCount(20);
-	c.setOutlineColor(col);
-	c.setOutlineThickness(2);
-	c.setFillColor(Color::Transparent);
-	c.setPosition(pos);
-	c.setOrigin(radius, radius);
-	window.draw(c);
-}
-
 bool CircleToCircle(const Vector2f& pos1, const Vector2f& pos2, float minDist)
 {
 	float dist = (pos1.x - pos2.x) * (pos1.x - pos2.x) +
 		(pos1.y - pos2.y) * (pos1.y - pos2.y);
-	dist = sqrtf(dist);
-	return dist <= minDist;
+	return dist <= minDist * minDist;
 }
 
-void CheckCollisions(vector<GameObj>& objects, RenderWindow& window, bool debug)
+void ContactJobs::Init(int numJobs, size_t perJob)
 {
-	if (objects.size() > 1)
+	found.resize(numJobs);
+	for (size_t i = 0; i < found.size(); ++i)
+		found[i].reserve(perJob);
+	bandRows.reserve(numJobs + 1);
+}
+
+/*
+Everything a band of collision rows needs, passed through the worker pool
+*/
+struct CollideJob {
+	const CollisionGrid *pGrid;
+	ContactJobs *pJobs;
+};
+
+void CollideBand(void *pData, int job)
+{
+	CollideJob& cj = *reinterpret_cast<CollideJob*>(pData);
+	const vector<int>& bandRows = cj.pJobs->bandRows;
+	vector<Contact>& found = cj.pJobs->found[job];
+	found.clear();
+	cj.pGrid->FindPairsInRows(bandRows[job], bandRows[job + 1], [&found](unsigned int a, unsigned int b) {
+		found.push_back((a < b) ? Contact{ a, b } : Contact{ b, a });
+	});
+}
+
+void CheckCollisions(const vector<GameObj>& objects, const Projectiles& shots, CollisionGrid& grid, FrameVector<Contact>& contacts,
+	WorkerPool *pWorkers, ContactJobs *pJobs)
+{
+	contacts.clear();
+	grid.Build(objects, shots);
+	if (!pWorkers || !pJobs || pJobs->found.empty() || grid.circles.num < GC::MIN_COLLIDE_CIRCLES)
 	{
-		for (size_t i = 0; i < objects.size(); ++i)
-		{
-			GameObj& a = objects[i];
-			if (a.active)
-			{
-				if (i < (objects.size() - 1))
-					for (size_t ii = i + 1; ii < (objects.size()); ++ii)
-					{
-						GameObj& b = objects[ii];
-						if (b.active)
-						{
-							if (CircleToCircle(a.spr.getPosition(), b.spr.getPosition(), a.radius + b.radius))
-							{
-								a.colliding = true;
-								b.colliding = true;
-								a.Hit(b);
-								b.Hit(a);
-							}
-						}
-					}
-				if (debug)
-				{
-					Color col = Color::Green;
-					if (a.colliding)
-						col = Color::Red;
-					DrawCircle(window, a.spr.getPosition(), a.radius, col);
-				}
-			}
-		}
+		grid.FindPairs([&contacts](unsigned int a, unsigned int b) {
+			contacts.push_back((a < b) ? Contact{ a, b } : Contact{ b, a });
+		});
+		return;
 	}
+	//bands of rows never find the same pair, so each can go in its own list without locking
+	int numJobs = min((int)pJobs->found.size(), grid.rows);
+	grid.SplitRows(numJobs, pJobs->bandRows);
+	CollideJob cj{ &grid, pJobs };
+	pWorkers->Run(numJobs, CollideBand, &cj);
+	//merged in band order, ResolveContacts sorts them anyway
+	size_t total = 0;
+	for (int i = 0; i < numJobs; ++i)
+		total += pJobs->found[i].size();
+	contacts.reserve(total);
+	for (int i = 0; i < numJobs; ++i)
+		contacts.insert(contacts.end(), pJobs->found[i].begin(), pJobs->found[i].end());
 }
 
 
 bool IsColliding(GameObj& obj, vector<GameObj>& objects)
 {
 	assert(obj.active);
+	const Vector2f& pos = obj.spr.getPosition();
+	//gather the other active objects 8 at a time and test them all at once
+	float xs[GC::SIMD_WIDTH], ys[GC::SIMD_WIDTH], rs[GC::SIMD_WIDTH];
+	int num = 0;
 	size_t idx = 0;
 	bool colliding = false;
 	while (idx < objects.size() && !colliding) {
 
 		if (&obj != &objects[idx] && objects[idx].active)
 		{
-			const Vector2f& posA = obj.spr.getPosition();
 			const Vector2f& posB = objects[idx].spr.getPosition();
-			float dist = obj.radius + objects[idx].radius;
-			colliding = CircleToCircle(posA, posB, dist);
+			xs[num] = posB.x;
+			ys[num] = posB.y;
+			rs[num] = objects[idx].radius;
+			++num;
 		}
 		++idx;
+		if (num == GC::SIMD_WIDTH || (idx == objects.size() && num > 0))
+		{
+			for (int i = num; i < GC::SIMD_WIDTH; ++i)
+			{
+				xs[i] = ys[i] = GC::PAD_POS;
+				rs[i] = 0;
+			}
+			colliding = CircleVsCircles8(pos.x, pos.y, obj.radius, xs, ys, rs) != 0;
+			num = 0;
+		}
 	}
 	return colliding;
 }
 
-void Game::PlaceExistingRocks(RenderWindow& window)
+float RandomRockRadius()
+{
+	return GC::ROCK_RAD.x + (float)(rand() % (int)(GC::ROCK_RAD.y - GC::ROCK_RAD.x));
+}
+
+void GenerateRockLayouts(const Vector2u& area, int num, vector<DiskLayout>& layouts)
+{
+	layouts.resize(num);
+	vector<float> radii(GC::NUM_ROCKS);
+	vector<Disk> none;
+	for (int i = 0; i < num; ++i)
+	{
+		for (size_t r = 0; r < radii.size(); ++r)
+			radii[r] = RandomRockRadius();
+		layouts[i].area = area;
+		PoissonDiskLayout(area, radii, GC::ROCK_MIN_DIST, none, layouts[i].disks, GC::PLACE_TRIES);
+	}
+}
+
+//gather up the active objects so the layout keeps clear of them
+void GetFixedDisks(const vector<GameObj>& objects, vector<Disk>& fixed)
 {
+	fixed.clear();
+	for (size_t i = 0; i < objects.size(); ++i)
+		if (objects[i].active && objects[i].type != GameObj::ObjectT::Rock)
+			fixed.push_back(Disk{ objects[i].spr.getPosition(), objects[i].radius });
+}
+
+void Game::PlaceExistingRocks(const Vector2u& screenSz)
+{
+	vector<size_t> rocks;
+	vector<float> radii;
 	for (size_t i = 0; i < objects.size(); ++i)
 	{
 		if (objects[i].type == GameObj::ObjectT::Rock)
 		{
-			GameObj& rock = objects[i];
-			rock.radius *= GC::ROCK_MIN_DIST;
-			rock.active = true;
-			int tries = 0;
-			do {
-				tries++;
-				float x = (float)(rand() % window.getSize().x);
-				float y = (float)(rand() % window.getSize().y);
-				rock.spr.setPosition(x, y);
-			} while (tries < GC::PLACE_TRIES && IsColliding(rock, objects));
-			rock.radius *= 1 / GC::ROCK_MIN_DIST;
+			rocks.push_back(i);
+			radii.push_back(objects[i].radius);
 		}
 	}
+	vector<Disk> fixed, disks;
+	GetFixedDisks(objects, fixed);
+	PoissonDiskLayout(screenSz, radii, GC::ROCK_MIN_DIST, fixed, disks, GC::PLACE_TRIES);
+	for (size_t i = 0; i < rocks.size(); ++i)
+	{
+		GameObj& rock = objects[rocks[i]];
+		rock.active = i < disks.size();		//if the screen filled up the rest stay asleep
+		if (rock.active)
+			rock.spr.setPosition(disks[i].pos);
+	}
 }
 
-void Game::PlaceRocks(RenderWindow& window, Texture& tex)
+void Game::PlaceRocks(const Vector2u& screenSz, Texture& tex)
 {
-	bool space = true;
-	int ctr = GC::NUM_ROCKS;
-	while (space && ctr)
+	//a pre-generated layout for this screen size is quickest, otherwise make one now
+	vector<const DiskLayout*> matching;
+	for (size_t i = 0; i < rockLayouts.size(); ++i)
+		if (rockLayouts[i].area == screenSz)
+			matching.push_back(&rockLayouts[i]);
+	vector<Disk> disks;
+	if (!matching.empty())
+		disks = matching[rand() % matching.size()]->disks;
+	else
+	{
+		vector<float> radii(GC::NUM_ROCKS);
+		for (size_t r = 0; r < radii.size(); ++r)
+			radii[r] = RandomRockRadius();
+		vector<Disk> fixed;
+		GetFixedDisks(objects, fixed);
+		PoissonDiskLayout(screenSz, radii, GC::ROCK_MIN_DIST, fixed, disks, GC::PLACE_TRIES);
+	}
+
+	for (size_t i = 0; i < disks.size(); ++i)
 	{
 		GameObj rock;
-		rock.Init(window, tex, GameObj::ObjectT::Rock,*this);
-		rock.radius *= GC::ROCK_MIN_DIST;
-		int tries = 0;
-		do {
-			tries++;
-			float x = (float)(rand() % window.getSize().x);
-			float y = (float)(rand() % window.getSize().y);
-			rock.spr.setPosition(x, y);
-		} while (tries < GC::PLACE_TRIES && IsColliding(rock, objects));
-		rock.radius *= 1 / GC::ROCK_MIN_DIST;
-		if (tries != GC::PLACE_TRIES)
+		rock.Init(screenSz, tex, GameObj::ObjectT::Rock, *this);
+		rock.active = true;
+		rock.radius = disks[i].radius;
+		float texW = (float)rock.spr.getTextureRect().width;
+		if (texW > 0)
+			rock.spr.setScale(disks[i].radius * 2.f / texW, disks[i].radius * 2.f / texW);
+		rock.spr.setPosition(disks[i].pos);
+		//a pre-generated layout doesn't know where the player is
+		if (matching.empty() || !IsColliding(rock, objects))
 			objects.push_back(rock);
-		else
-			space = false;
-		--ctr;
 	}
 }
 
-bool Spawn(GameObj::ObjectT type, RenderWindow& window, vector<GameObj>& objects, float extraClearance)
+bool Spawn(GameObj::ObjectT type, const Vector2u& screenSz, vector<GameObj>& objects, float extraClearance, Rng& rng)
 {
 	size_t idx = 0;
 	bool found = false;
@@ -263,8 +334,8 @@ bool Spawn(GameObj::ObjectT type, RenderWindow& window, vector<GameObj>& objects
 		obj.active = true;
 		obj.radius += extraClearance;
 		FloatRect r = obj.spr.getGlobalBounds();
-		float y = (r.height/2.f) + (rand() % (int)(window.getSize().y - r.height));
-		obj.spr.setPosition(window.getSize().x + r.width, y);
+		float y = (r.height/2.f) + rng.Range((int)(screenSz.y - r.height));
+		obj.spr.setPosition(screenSz.x + r.width, y);
 		if (IsColliding(obj, objects))
 		{
 			found = false;
@@ -275,10 +346,41 @@ bool Spawn(GameObj::ObjectT type, RenderWindow& window, vector<GameObj>& objects
 	return found;
 }
 
-void Game::Init(sf::RenderWindow & window) {
+void Game::LoadTex(const string& file, Texture& tex)
+{
+	if (!headless)
+	{
+		LoadTexture(file, tex);
+		return;
+	}
+	//a texture can't be made without a graphics card, keep the pixels for a SoftwareBackend
+	TexImage ti;
+	ti.pTex = &tex;
+	if (ti.img.loadFromFile(file))
+		texImages.push_back(ti);
+	else
+		assert(false);
+}
+
+Vector2u Game::TexSize(const Texture& tex) const
+{
+	for (const TexImage& ti : texImages)
+		if (ti.pTex == &tex)
+			return ti.img.getSize();
+	return tex.getSize();
+}
+
+void Game::Init(const sf::Vector2u& screenSz, bool headless_) {
 	
-	LoadTexture("data/Knight.png",texChar);
-	LoadTexture("data/bg2.png",texBullet);
+	headless = headless_;
+	texImages.clear();
+	LoadTex("data/Knight.png",texChar);
+	LoadTex("data/bg2.png",texBullet);
+	LoadTex("data/Enemy-Sprites.png", texEnemy);
+	LoadTex("data/bckgd1.jpg", texBackground);
+	animSys.Load("data/anims.txt");
+	LoadLayouts("data/rock_layouts.txt", rockLayouts);
+	particleSys.LoadPresets("data/effects.txt");
 	
 	
 	if (!font.loadFromFile("data/fonts/comic.ttf"))
@@ -286,59 +388,111 @@ void Game::Init(sf::RenderWindow & window) {
 
 	objects.clear();
 	GameObj obj;
-	objects.insert(objects.begin(), GC::NUM_ROCKS+GC::NUM_BULLETS+1+GC::NUM_ENEMIES, obj);
-	
-	size_t idx = 0, total=0;
-	
-	objects[idx++].Init(window, texChar, GameObj::ObjectT::player, *this);
-	for (idx; idx < total; ++idx)
-		objects[idx].Init(window, texBullet, GameObj::ObjectT::Bullet, *this);
-	
-
-	
-	
-	
-	
+	objects.insert(objects.begin(), GC::NUM_ROCKS+1+GC::NUM_ENEMIES, obj);
 	
-	total += GC::NUM_ROCKS + 1;
+	size_t idx = 0;
 	
+	objects[idx++].Init(screenSz, texChar, GameObj::ObjectT::player, *this);
+	for (size_t i = objects.size() - GC::NUM_ENEMIES; i < objects.size(); ++i)
+		objects[i].Init(screenSz, texEnemy, GameObj::ObjectT::Enemy, *this);
 
 	rockShipClearance = objects[0].spr.getGlobalBounds().width * 2.f;
 
-	//PlaceExistingRocks(window);
+	//PlaceExistingRocks(screenSz);
 
-	//particleSys.Init();
+	particleSys.Init(50, ParticleSys::OverflowT::RecycleOldest, GC::NUM_PARTICLES, !headless);
+	//headless there's no texture, the software renderer gets the dot's pixels and the sprites are told how big it is
+	if (headless)
+	{
+		TexImage ti;
+		ti.pTex = &particleSys.cache.texSprite;
+		Particles::MakeDot(ti.img);
+		texImages.push_back(ti);
+		for (Particle& p : particleSys.cache.particles)
+			p.spr.setTextureRect(IntRect(0, 0, GC::PARTICLE_DOT, GC::PARTICLE_DOT));
+	}
 
 	metrics.Load("data/scores.txt", false);
+
+	workers.Init();
+	cmdBuffers.resize(workers.GetNumThreads());
+	for (size_t i = 0; i < cmdBuffers.size(); ++i)
+		cmdBuffers[i].reserve(objects.size());
+	effectReqs.reserve(objects.size());
+	newEmitters.reserve(objects.size());
+	visible.reserve(objects.size());
+	scheduler.Reserve(objects.size() + 2);	//an event per object at most, plus the spawn timers
+	dueEvents.reserve(objects.size() + 2);
+	rockTimer.ev.type = GameEvent::EvT::SpawnRock;
+	enemyTimer.ev.type = GameEvent::EvT::SpawnEnemy;
+	projectiles.Init(&texBullet);
+	grid.Reserve(objects.size() + projectiles.x.size());
+	flowField.Init(screenSz);
+	contactJobs.Init(workers.GetNumThreads() * GC::COLLIDE_JOBS_PER_THREAD, objects.size());
+	frameArena.Init(GC::FRAME_ARENA_BYTES);
+
+	//make room now rather than mid game, snapshots grow with the bullets in flight, see ReserveSnapshots
+	Snapshot probe;
+	SaveSnapshot(probe);
+	snapBaseBytes = probe.data.size() * 2;
+	snapReserved = 0;
+	rewindBuf.resize(GC::REWIND_SLOTS);
+	ReserveSnapshots();
 }
 
-void Game::NewGame(sf::RenderWindow & window)
+void Game::ReserveSnapshots()
+{
+	const size_t need = snapBaseBytes + projectiles.SaveBytes(projectiles.num + GC::SNAPSHOT_SHOTS);
+	if (need <= snapReserved)
+		return;
+	//bullets only build up a little each frame, so keeping SNAPSHOT_SHOTS spare means a save never grows a buffer
+	quickSave.data.reserve(need);
+	undoSnap.data.reserve(need);
+	for (size_t i = 0; i < rewindBuf.size(); ++i)
+		rewindBuf[i].data.reserve(need);
+	snapReserved = need;
+}
+
+void Game::NewGame(const sf::Vector2u& screenSz)
 {
 	for (size_t i = 1; i < objects.size(); ++i)
 		objects[i].active = false;
-	objects[0].ResetShip(window);
-	rockTimer.Reset(0.5f, 1);
-	enemyTimer.Reset(2.f, 0.5f);
+	projectiles.Clear();
+	flowField.Clear();
+	objects[0].ResetShip(screenSz);
+	simTime = 0;
+	scheduler.Clear();
+	rockTimer.Reset(scheduler, simTime, 0.5f, 1);
+	enemyTimer.Reset(scheduler, simTime, 2.f, 0.5f);
+	debugDraw.Clear();
+	gameFrames = 0;
+	rewindCount = 0;
+	rewindTimer = 0;
 }
 
-void Game::UpdateInGame(sf::RenderWindow & window, float elapsed, bool fire) {
-	if (rockTimer.Cycle(elapsed))
-	{
-		if (Spawn(GameObj::ObjectT::Rock, window, objects, rockShipClearance))
-			rockTimer.Reset();
-	}
-
-	if (enemyTimer.Cycle(elapsed))
-	{
-		if (Spawn(GameObj::ObjectT::Enemy, window, objects, objects[0].spr.getGlobalBounds().width * 2))
-			enemyTimer.Reset();
-	}
-
-	CheckCollisions(objects, window, false);
-	for (size_t i = 0; i < objects.size(); ++i)
-		objects[i].Update(window, elapsed, fire);
-
-//	particleSys.Update(elapsed);
+void Game::UpdateInGame(const sf::Vector2u& screenSz, float elapsed, const InputState& input) {
+	++gameFrames;
+	simTime += elapsed;
+	scheduler.Advance(simTime, dueEvents);
+	HandleEvents(screenSz);
+
+	CheckCollisions(objects, projectiles, grid, contacts, &workers, &contactJobs);
+	ResolveContacts();
+	//the enemies all steer by this, so it has to be ready before any of them move
+	flowField.Update(objects, objects[0].spr.getPosition());
+	if (debug)
+		DebugDrawCollisions();
+	UpdateObjects(screenSz, elapsed, input);
+	//anything a bullet width off screen is finished
+	const float edge = GC::PROJECTILE_SIZE;
+	projectiles.SetArea(FloatRect(-edge, -edge, screenSz.x + edge * 2, screenSz.y + edge * 2));
+	ApplyCommands();
+	projectiles.Update(simTime);
+	SpawnEffects();
+	CullObjects(FloatRect(0, 0, (float)screenSz.x, (float)screenSz.y));
+	animSys.Update(elapsed, objects, visible);
+
+	particleSys.Update(elapsed);
 
 	if (metrics.lives <= 0 && !particleSys.cache.IsBusy() && particleSys.GetNumActiveEmitters() == 0) {
 		//game over
@@ -354,8 +508,187 @@ void Game::UpdateInGame(sf::RenderWindow & window, float elapsed, bool fire) {
 	}
 }
 
-void Game::Update(sf::RenderWindow & window, float elapsed, bool fire, char key) {
+/*
+Everything an update chunk needs, passed through the worker pool
+*/
+struct UpdateJob {
+	Game *pGame;
+	Vector2u screenSz;
+	float elapsed;
+	const InputState *pInput;
+	size_t chunkSz;		//objects per chunk, the last chunk may be short
+};
+
+void UpdateChunk(void *pData, int job)
+{
+	UpdateJob& uj = *reinterpret_cast<UpdateJob*>(pData);
+	vector<GameObj>& objects = uj.pGame->objects;
+	CmdBuffer& cmds = uj.pGame->cmdBuffers[job];
+	size_t last = min(objects.size(), (job + 1) * uj.chunkSz);
+	for (size_t i = job * uj.chunkSz; i < last; ++i)
+		objects[i].Update(uj.screenSz, uj.elapsed, *uj.pInput, cmds);
+}
+
+void Game::UpdateObjects(const Vector2u& screenSz, float elapsed, const InputState& input)
+{
+	assert(!cmdBuffers.empty());
+	size_t numChunks = objects.size() / GC::MIN_UPDATE_CHUNK;
+	numChunks = max((size_t)1, min(numChunks, cmdBuffers.size()));
+	UpdateJob uj{ this, screenSz, elapsed, &input, (objects.size() + numChunks - 1) / numChunks };
+	workers.Run((int)numChunks, UpdateChunk, &uj);
+}
+
+void Game::ApplyCommands()
+{
+	for (size_t b = 0; b < cmdBuffers.size(); ++b)
+	{
+		CmdBuffer& cmds = cmdBuffers[b];
+		for (size_t i = 0; i < cmds.size(); ++i)
+		{
+			GameCmd& cmd = cmds[i];
+			switch (cmd.type)
+			{
+			case GameCmd::CmdT::FireBullet:
+				cmd.pObj->FireBullet(cmd.pos);
+				break;
+			case GameCmd::CmdT::TakeDamage:
+				//something earlier in the queue may already have finished it off
+				if (cmd.pObj->active)
+					cmd.pObj->TakeDamage(cmd.amount, cmd.pos);
+				break;
+			default:
+				assert(false);
+			}
+		}
+		cmds.clear();
+	}
+}
+
+void Game::HandleEvents(const Vector2u& screenSz)
+{
+	for (size_t i = 0; i < dueEvents.size(); ++i)
+	{
+		const GameEvent& ev = dueEvents[i];
+		switch (ev.type)
+		{
+		case GameEvent::EvT::SpawnRock:
+			if (Spawn(GameObj::ObjectT::Rock, screenSz, objects, rockShipClearance, rng))
+				rockTimer.Reset(scheduler, simTime);
+			else
+				rockTimer.Retry(scheduler, simTime);
+			break;
+		case GameEvent::EvT::SpawnEnemy:
+			if (Spawn(GameObj::ObjectT::Enemy, screenSz, objects, objects[0].spr.getGlobalBounds().width * 2, rng))
+				enemyTimer.Reset(scheduler, simTime);
+			else
+				enemyTimer.Retry(scheduler, simTime);
+			break;
+		case GameEvent::EvT::EnemyFire:
+			objects[ev.obj].EnemyShoot();
+			break;
+		default:
+			assert(false);
+		}
+	}
+	dueEvents.clear();
+}
+
+void Game::ResolveContacts()
+{
+	//whoever finds the contacts, the outcome doesn't depend on the order they were found in
+	sort(contacts.begin(), contacts.end(), [](const Contact& lhs, const Contact& rhs) {
+		return (lhs.a == rhs.a) ? lhs.b < rhs.b : lhs.a < rhs.a;
+	});
+	CmdBuffer& cmds = cmdBuffers[0];
+	const unsigned int numObjects = (unsigned int)objects.size();
+	for (size_t i = 0; i < contacts.size(); ++i)
+	{
+		GameObj& a = objects[contacts[i].a];
+		if (contacts[i].b >= numObjects)
+		{
+			//bullets are always after the objects, so only b can be one
+			a.colliding = true;
+			ProjectileHit(contacts[i].b - numObjects, a, cmds);
+			continue;
+		}
+		GameObj& b = objects[contacts[i].b];
+		a.colliding = true;
+		b.colliding = true;
+		a.Hit(b, cmds);
+		b.Hit(a, cmds);
+	}
+	ApplyCommands();
+}
+
+void Game::ProjectileHit(int shot, GameObj& target, CmdBuffer& cmds)
+{
+	const Vector2f pos = projectiles.GetPos(shot);
+	GameObj& owner = objects[projectiles.owner[shot]];
+	if (owner.type != target.type)
+	{
+		GameCmd cmd;
+		cmd.type = GameCmd::CmdT::TakeDamage;
+		cmd.pObj = &target;
+		cmd.pOther = &owner;
+		cmd.pos = pos;
+		cmd.amount = 1;
+		cmds.push_back(cmd);
+	}
+	//it may already have been used up on something else this frame
+	if (projectiles.IsLive(shot))
+	{
+		projectiles.Kill(shot);
+		effectReqs.push_back(EffectReq{ EffectT::BulletSplash, pos, Vector2f{ -GC::ROCK_SPEED,0 }, GC::PROJECTILE_RADIUS });
+	}
+}
+
+void Game::DebugDrawCollisions()
+{
+	const Color gridCol(255, 255, 255, 64);
+	for (int cy = 0; cy < grid.rows; ++cy)
+		for (int cx = 0; cx < grid.cols; ++cx)
+		{
+			if (!grid.CellEmpty(grid.CellIdx(cx, cy)))
+				debugDraw.Box(FloatRect(grid.origin.x + cx * grid.cellSz, grid.origin.y + cy * grid.cellSz, grid.cellSz, grid.cellSz), gridCol);
+		}
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const GameObj& obj = objects[i];
+		if (obj.active)
+			debugDraw.Circle(obj.spr.getPosition(), obj.radius, obj.colliding ? Color::Red : Color::Green);
+	}
+}
+
+void Game::SpawnEffects()
+{
+	if (effectReqs.empty())
+		return;
+	int num = particleSys.GetNewEmitters((int)effectReqs.size(), newEmitters);
+	for (int i = 0; i < num; ++i)
+		particleSys.SetupEffect(*newEmitters[i], effectReqs[i]);
+	effectReqs.clear();
+}
+
+void Game::CullObjects(const FloatRect& view)
+{
+	visible.clear();
+	numCulled = 0;
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const GameObj& obj = objects[i];
+		if (!obj.active)
+			continue;
+		if (obj.spr.getGlobalBounds().intersects(view))
+			visible.push_back((unsigned int)i);
+		else
+			++numCulled;
+	}
+}
+
+void Game::Update(const sf::Vector2u& screenSz, float elapsed, const InputState& input) {
+	frameAllocStart = HeapAllocCount();
 	timer += elapsed;
+	bool fire = input.WasReleased(Keyboard::Space);
 	switch (mode)
 	{
 	case Mode::INTRO:
@@ -363,17 +696,30 @@ void Game::Update(sf::RenderWindow & window, float elapsed, bool fire, char key)
 		{
 			metrics.Restart();
 			mode = Mode::GAME;
-			NewGame(window);
+			NewGame(screenSz);
 		}
 		break;
 	case Mode::GAME:
-		UpdateInGame(window, elapsed, fire);
+		if (input.WasPressed(Keyboard::F5))
+			QuickSave();
+		else if (input.WasPressed(Keyboard::F9))
+			QuickLoad();
+		else if (input.WasPressed(Keyboard::F2))
+			Rewind();
+		UpdateInGame(screenSz, elapsed, input);
+		RecordRewind(elapsed);
 		
 		break;
 	case Mode::ENTER_NAME:	
-		if(key!=-1)
-			metrics.name += key;
-		if (metrics.name.size() > 1 && Keyboard::isKeyPressed(Keyboard::Return)) {
+		for (size_t i = 0; i < input.text.size(); ++i)
+		{
+			char c = input.text[i];
+			if (isdigit(c) || isalpha(c))
+				metrics.name += c;
+			else if (c == GC::BACKSPACE_KEY && !metrics.name.empty())
+				metrics.name.pop_back();
+		}
+		if (metrics.name.size() > 1 && input.WasPressed(Keyboard::Return)) {
 			mode = Mode::GAME_OVER;
 			metrics.SortAndUpdatePlayerData();
 			metrics.Save();
@@ -391,70 +737,223 @@ void Game::Update(sf::RenderWindow & window, float elapsed, bool fire, char key)
 
 }
 
-void Game::RenderGameOver(sf::RenderWindow & window, float elapsed) {
+void Game::RenderGameOver(RenderBackend& gfx, float elapsed) {
+	//laid out by whoever draws it, measuring text here could be on the wrong thread (see RenderFrame)
 	Text txt("Game over press <space>", font, 50);
-	FloatRect fr = txt.getGlobalBounds();
-	txt.setPosition(window.getSize().x / 2.f - fr.width / 2.f, window.getSize().y - fr.height*1.2f);
-	window.draw(txt);
+	txt.setPosition(gfx.GetSize().x / 2.f, gfx.GetSize().y - txt.getCharacterSize() * 0.2f);
+	gfx.DrawAligned(txt, Vector2f(0.5f, 1.f));
 	txt.setString("High scores");
-	txt.setPosition(window.getSize().x / 2.f - fr.width / 2.f, fr.height*0.1f);
-	window.draw(txt);
+	txt.setPosition(gfx.GetSize().x / 2.f, txt.getCharacterSize() * 0.1f);
+	gfx.DrawAligned(txt, Vector2f(0.5f, 0.f));
 
 }
-void Renderbackground(sf::RenderWindow& window)
+void Renderbackground(RenderBackend& gfx, const Texture& background, const Vector2u& texSz)
 {
-	Texture background;
-	LoadTexture("data/bckgd1.jpg",background);
 	Sprite bg;
+	//the size is passed in as a headless texture is never loaded
 	bg.setTexture(background);
-	window.draw(bg);
+	bg.setTextureRect(IntRect(0, 0, texSz.x, texSz.y));
+	gfx.Draw(bg);
 }
 //loads the background 
-void Game::Render(sf::RenderWindow & window, float elapsed) {
+void Game::Render(RenderBackend& gfx, float elapsed, bool withHUD) {
 
 	switch (mode)
 	{
 		case Mode::INTRO:
 		{
-			Text txt("Legend Quest 2D 1.0\n\n     Press <space>", font, 50);
-			FloatRect fr = txt.getGlobalBounds();			
-			txt.setPosition(window.getSize().x/2.f - fr.width / 2.f, window.getSize().y/2.f - fr.height / 2.f);
-			window.draw(txt);		
+			layers.Draw(gfx, LayerCompositor::LayerT::Menu, (size_t)mode, [this](RenderBackend& layerGfx) {
+				Text txt("Legend Quest 2D 1.0\n\n     Press <space>", font, 50);
+				txt.setPosition(layerGfx.GetSize().x / 2.f, layerGfx.GetSize().y / 2.f);
+				layerGfx.DrawAligned(txt, Vector2f(0.5f, 0.5f));
+			});
 			break;
 		}
 		case Mode::GAME:
 		{
-			Renderbackground (window);
-			for (size_t i = 0; i < objects.size(); ++i)
-			{
-			objects[i].Render(window, elapsed);
-
-			
-				
-			
-			
-			}		
-			//particleSys.Render(window, elapsed);
-			RenderHUD(window, elapsed, font);
+			layers.Draw(gfx, LayerCompositor::LayerT::Background, (size_t)&texBackground, [this](RenderBackend& layerGfx) {
+				Renderbackground(layerGfx, texBackground, TexSize(texBackground));
+			});
+			for (size_t i = 0; i < visible.size(); ++i)
+				objects[visible[i]].Render(gfx, elapsed);
+			projectiles.Render(gfx);
+			particleSys.Render(gfx, elapsed);
+			debugDraw.Render(gfx);
+			if (withHUD)
+				RenderHUD(gfx, elapsed, font);
 		}
 		break;
 	case Mode::ENTER_NAME:
 		{
-			Text txt("Game over - Enter name <return>: " + metrics.name, font, 40);
-			FloatRect fr = txt.getGlobalBounds();
-			txt.setPosition(window.getSize().x / 2.f - fr.width / 2.f, window.getSize().y / 2.f - fr.height / 2.f);
-			window.draw(txt);
+			//it changes as the name is typed
+			size_t key = hash<string>()(metrics.name) * 31 + (size_t)mode;
+			layers.Draw(gfx, LayerCompositor::LayerT::Menu, key, [this](RenderBackend& layerGfx) {
+				FrameString str("Game over - Enter name <return>: ", FrameAlloc<char>(frameArena));
+				str += metrics.name.c_str();
+				Text txt(str.c_str(), font, 40);
+				txt.setPosition(layerGfx.GetSize().x / 2.f, layerGfx.GetSize().y / 2.f);
+				layerGfx.DrawAligned(txt, Vector2f(0.5f, 0.5f));
+			});
 			break;
 		}
 	case Mode::GAME_OVER:
 		{
-			RenderGameOver(window,elapsed);
+			layers.Draw(gfx, LayerCompositor::LayerT::Menu, (size_t)mode, [this, elapsed](RenderBackend& layerGfx) {
+				RenderGameOver(layerGfx, elapsed);
+			});
 			break;
 		}
 	default:
 		assert(false);
 	}
+
+	//once a game has settled down nothing in the update or render should touch the heap,
+	//the debug overlay is let off as it has to build its text every frame
+	frameAllocs = (int)(HeapAllocCount() - frameAllocStart);
+	assert(frameAllocs == 0 || mode != Mode::GAME || gameFrames < GC::ALLOC_WARMUP_FRAMES || debug);
+}
+
+void Game::SaveSnapshot(Snapshot& snap) const
+{
+	snap.Clear();
+	snap.Write(GC::SNAPSHOT_MAGIC);
+	snap.Write(GC::SNAPSHOT_VERSION);
+	snap.Write(objects.size());
+	for (size_t i = 0; i < objects.size(); ++i)
+		objects[i].Save(snap);
+	particleSys.Save(snap);
+	projectiles.Save(snap);
+	scheduler.Save(snap);
+	snap.Write(rockTimer);
+	snap.Write(enemyTimer);
+	snap.Write(metrics.score);
+	snap.Write(metrics.lives);
+	snap.Write(rng);
+	snap.Write(timer);
+	snap.Write(simTime);
+	snap.Write(mode);
+	snap.Write(gameFrames);
+}
+
+bool Game::ReadSnapshotHeader(Snapshot& snap) const
+{
+	snap.StartRead();
+	unsigned int magic;
+	int version;
+	size_t numObjects;
+	snap.Read(magic);
+	snap.Read(version);
+	snap.Read(numObjects);
+	return !snap.failed && magic == GC::SNAPSHOT_MAGIC && version == GC::SNAPSHOT_VERSION && numObjects == objects.size();
+}
+
+bool Game::ReadSnapshot(Snapshot& snap)
+{
+	if (!ReadSnapshotHeader(snap))
+		return false;
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		objects[i].Load(snap);
+		if (objects[i].anim.clipId >= (int)animSys.clips.size())
+			snap.Fail();
+	}
+	particleSys.Load(snap);
+	projectiles.Load(snap);
+	scheduler.Load(snap);
+	snap.Read(rockTimer);
+	snap.Read(enemyTimer);
+	snap.Read(metrics.score);
+	snap.Read(metrics.lives);
+	snap.Read(rng);
+	snap.Read(timer);
+	snap.Read(simTime);
+	snap.Read(mode);
+	snap.Read(gameFrames);
+	//indices into the objects array
+	if (mode > Mode::ENTER_NAME)
+		snap.Fail();
+	for (int i = 0; i < projectiles.num; ++i)
+		if (projectiles.owner[i] < 0 || projectiles.owner[i] >= (int)objects.size())
+			snap.Fail();
+	for (const TimingWheel::Node& node : scheduler.nodes)
+		if (node.slot >= 0 && (node.ev.type > GameEvent::EvT::EnemyFire || node.ev.obj >= objects.size()))
+			snap.Fail();
+	return snap.ReadOK();
 }
 
-void Game::RenderHUD(sf::RenderWindow & window, float elapsed, sf::Font & font) {
+bool Game::LoadSnapshot(Snapshot& snap)
+{
+	if (!ReadSnapshotHeader(snap))
+		return false;
+	//if it turns out to be bad halfway through, put back how things were
+	SaveSnapshot(undoSnap);
+	if (!ReadSnapshot(snap))
+	{
+		if (!ReadSnapshot(undoSnap))
+			assert(false);
+		return false;
+	}
+	//anything queued was about the moment we just left
+	debugDraw.Clear();
+	effectReqs.clear();
+	flowField.Clear();
+	return true;
+}
+
+void Game::QuickSave()
+{
+	SaveSnapshot(quickSave);
+}
+
+bool Game::QuickLoad()
+{
+	return !quickSave.Empty() && LoadSnapshot(quickSave);
+}
+
+void Game::RecordRewind(float elapsed)
+{
+	rewindTimer += elapsed;
+	if (rewindTimer < GC::REWIND_INTERVAL || mode != Mode::GAME)
+		return;
+	rewindTimer = 0;
+	rewindNewest = (rewindNewest + 1) % GC::REWIND_SLOTS;
+	SaveSnapshot(rewindBuf[rewindNewest]);
+	rewindCount = min(rewindCount + 1, GC::REWIND_SLOTS);
+}
+
+bool Game::Rewind()
+{
+	if (rewindCount == 0)
+		return false;
+	bool loaded = LoadSnapshot(rewindBuf[rewindNewest]);
+	rewindNewest = (rewindNewest + GC::REWIND_SLOTS - 1) % GC::REWIND_SLOTS;
+	--rewindCount;
+	rewindTimer = 0;
+	return loaded;
+}
+
+void Game::EndFrame()
+{
+	//the contact list's memory is in the arena, let go of it first
+	FrameVector<Contact>(FrameAlloc<Contact>(frameArena)).swap(contacts);
+	frameArena.Reset();
+	//outside Update and Render, growing them here doesn't count against the frame
+	ReserveSnapshots();
+}
+
+void Game::RenderHUD(RenderBackend& gfx, float elapsed, sf::Font & font) {
+	if (debug)
+	{
+		const Particles& cache = particleSys.cache;
+		stringstream ss;
+		ss << "objects " << visible.size() << " drawn " << numCulled << " culled\n";
+		ss << "particles " << cache.numDrawn << " drawn " << cache.numCulled << " culled\n";
+		ss << "resolution " << (int)(resScale * 100) << "%\n";
+		ss << "layers " << layers.hits << " cached " << layers.redraws << " redrawn " << layers.uncached << " uncached\n";
+		FrameSummary fs = metrics.telemetry.Summary(Telemetry::Frame);
+		ss << "frame ms p50 " << fs.p50 << " p99 " << fs.p99 << " max " << fs.max << " over " << fs.overBudget;
+		Text txt(ss.str(), font, 14);
+		txt.setPosition(4, 4);
+		gfx.Draw(txt);
+	}
 }
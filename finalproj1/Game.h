@@ -2,9 +2,21 @@
 
 #include "SFML/Graphics.hpp"
 #include "ParticleSys.h"
+#include "Anim.h"
 #include "Utils.h"
 #include "GameObj.h"
 #include "MyDB.h"
+#include "WorkerPool.h"
+#include "Collision.h"
+#include "PoissonDisk.h"
+#include "DebugDraw.h"
+#include "RenderBackend.h"
+#include "Telemetry.h"
+#include "FrameArena.h"
+#include "Projectiles.h"
+#include "Scheduler.h"
+#include "FlowField.h"
+#include "LayerCompositor.h"
 
 /*
 A box to put Games Constants in.
@@ -18,18 +30,32 @@ namespace GC
 	const Dim2Di SCREEN_RES{ 1200,800 };
 	const float SPEED = 250.f;			//ship speed
 	const float SCREEN_EDGE = 0.6f;		//how close to the edge the ship can get
-	const char ESCAPE_KEY{ 27 };
 	const char BACKSPACE_KEY{ 8 };
 	const float ROCK_MIN_DIST = 2.15f;	//used when placing rocks to stop them getting too close
 	const int NUM_ROCKS = 50;			//how many to place
-	const int PLACE_TRIES = 10;			//how many times to try and place before giving up
+	const int PLACE_TRIES = 30;			//how many times to try growing a new rock out from each placed one
 	const float ROCK_SPEED = 150.f;
 	const Dim2Df ROCK_RAD{ 10.f,40.f };
-	const int NUM_BULLETS = 50;
 	const int NUM_ENEMIES = 50;
 	const float ENEMY_SPEED = 150;
+	const float ENEMY_TURN = 4.f;		//how quickly enemies swing round to a new heading, bigger is sharper
+	const float BULLET_SPEED = 250;		//player bullets
 	const float ENEMY_BULLET_SPEED = 400;
+	const float ENEMY_FIRE_DELAY = 1.5f;	//seconds between enemy shots
+	const int ENEMY_SHOTS = 5;			//bullets in each enemy shot
+	const float ENEMY_SPREAD = 0.5f;	//radians the fan of enemy bullets covers
+	const float PI = 3.14159265f;
 	const int NUM_LIVES = 3;
+	const int MIN_UPDATE_CHUNK = 64;	//don't bother sharing fewer objects than this with another thread
+	const int MIN_COLLIDE_CIRCLES = 512;	//with fewer circles than this the contacts are found on one thread
+	const int COLLIDE_JOBS_PER_THREAD = 4;	//bands of grid rows per thread, more bands evens out busy and quiet areas
+	const size_t FRAME_ARENA_BYTES = 256 * 1024;	//memory for data that only lasts one frame
+	const int ALLOC_WARMUP_FRAMES = 120;	//frames into a game before containers should have stopped growing
+	const unsigned int SNAPSHOT_MAGIC = 0x4C513244;	//"LQ2D", first thing in every snapshot
+	const int SNAPSHOT_VERSION = 6;		//change this whenever what goes in a snapshot changes
+	const int REWIND_SLOTS = 10;		//how many snapshots the rewind buffer holds
+	const int SNAPSHOT_SHOTS = 1024;	//room in every snapshot for this many more bullets than are in flight
+	const float REWIND_INTERVAL = 0.5f;	//seconds between rewind snapshots
 }
 
 /*
@@ -37,17 +63,21 @@ Data about the game for high scores and possibly
 tracking stats about players
 */
 struct Metrics {
-	const std::string VERSION = "1.4";	//change this every time the game changes significantly
+	const std::string VERSION = "1.5";	//change this every time the game changes significantly
+	const std::string VERSION_NO_PERF = "1.4";	//scores saved before the frame time figures, still read so they aren't lost
 	int score;				//current session score
 	int lives;				//current session lives
 	std::string name;		//current player
 	bool useDB = true;		//database or text file?
 	MyDB db;	//a database wrapper object for sqlite
+	Telemetry telemetry;	//frame times, the main loop feeds it every frame
 
 	//package some data into an object so we can store them in a container
 	struct PlayerData {
 		std::string name;
 		int score;
+		FrameSummary perf;	//how smoothly their game ran
+		int cores = 0;		//hardware threads on the machine it ran on
 	};
 	std::vector<PlayerData> playerData;		//info about the last 10 players
 	std::string filePath;		//where we are storing the data
@@ -86,6 +116,29 @@ struct Metrics {
 };
 
 
+/*
+Two objects found touching by CheckCollisions, what happens
+because of it is decided later by Game::ResolveContacts
+*/
+struct Contact {
+	unsigned int a, b;	//indices into the objects array, or past the end for a bullet (see CheckCollisions), a is always less than b
+};
+
+/*
+Scratch space for finding contacts on several threads at once,
+each job searches a band of grid rows into its own list
+*/
+struct ContactJobs {
+	std::vector<std::vector<Contact>> found;	//one list per job
+	std::vector<int> bandRows;		//first grid row of each job's band, one extra on the end
+
+	/*
+	numJobs - most bands the rows will be split into
+	perJob - contacts each list can hold before it has to grow
+	*/
+	void Init(int numJobs, size_t perJob);
+};
+
 /*
 Manage the asteroid dodging game
 */
@@ -98,65 +151,181 @@ struct Game
 	sf::Texture texRock;
 	sf::Texture texBullet;
 	sf::Texture texEnemy;
+	sf::Texture texBackground;
 
 	std::vector<GameObj> objects;	//anything moving around
+	Projectiles projectiles;		//every bullet in flight, far too many to be objects
+	std::vector<DiskLayout> rockLayouts;	//pre-generated rock positions, see GenerateRockLayouts
 	
-	SpawnTimer rockTimer;	//we need timers so rocks and enemies appear slowly
+	SpawnTimer rockTimer;	//we need timers so rocks and enemies appear slowly, they go off through the scheduler
 	SpawnTimer enemyTimer;
 	float rockShipClearance;	//when placing an asteroid, how many ship lengths away from other rocks should it be, harder = smaller
 	ParticleSys particleSys;	//this object makes pretty explosions
+	AnimSys animSys;			//all the animation clips, steps every animating object once a frame
 	sf::Font font;		//we need a font to use
 	Metrics metrics;	//an object to record info about the player, statistics
 	float timer = 0;	//like a main clock for the whole game, useful when timing things
+	float simTime = 0;	//seconds of game play since NewGame, the scheduler runs on this
+	TimingWheel scheduler;	//everything timed: spawns, enemy shots
+	std::vector<GameEvent> dueEvents;	//scratch, what the scheduler handed back this frame
+	Rng rng;			//all the random numbers game play needs, saved in snapshots so replays match
+	Snapshot quickSave;				//F5 saves here, F9 goes back to it
+	Snapshot undoSnap;				//how things were before a load, in case the snapshot turns out to be bad
+	std::vector<Snapshot> rewindBuf;	//a snapshot every REWIND_INTERVAL seconds, F2 steps back through them
+	int rewindNewest = 0;			//slot in rewindBuf holding the latest one
+	size_t snapBaseBytes = 0;		//a snapshot with no bullets in flight fits in this, with room to spare
+	size_t snapReserved = 0;		//every snapshot buffer has at least this much room
+	int rewindCount = 0;			//how many slots hold a snapshot we can go back to
+	float rewindTimer = 0;			//time since the last rewind snapshot
+	WorkerPool workers;	//threads to share the object updates across
+	std::vector<CmdBuffer> cmdBuffers;	//one per update chunk, what objects want doing to each other
+	CollisionGrid grid;					//broadphase, rebuilt every frame
+	FlowField flowField;				//the way to the player around the rocks, shared by every enemy
+	FrameArena frameArena;				//per frame scratch memory, emptied by EndFrame
+	FrameVector<Contact> contacts{ FrameAlloc<Contact>(frameArena) };	//everything touching this frame
+	ContactJobs contactJobs;			//per thread contact lists, merged into contacts
+	std::vector<EffectReq> effectReqs;	//explosions etc waiting for an emitter
+	std::vector<Emitter*> newEmitters;	//scratch space for SpawnEffects
+	bool debug = false;					//show collision circles and the broadphase grid
+	DebugDraw debugDraw;				//debug shapes queued during the update, drawn in one go by Render
+	LayerCompositor layers;				//the background and menu screens, only drawn again when they change
+	std::vector<unsigned int> visible;	//active objects on screen this frame, in object order so the draw order doesn't change
+	int numCulled = 0;					//active objects left out of visible this frame
+	long long frameAllocStart = 0;		//HeapAllocCount() when this frame's update started
+	int frameAllocs = 0;				//heap allocations during the last update and render (debug builds only)
+	int gameFrames = 0;					//frames since this game started
+	float resScale = 1;					//fraction of the window resolution the world was last drawn at, see DynamicRes
+	struct TexImage {
+		const sf::Texture *pTex;		//which texture these pixels are for
+		sf::Image img;
+	};
+	bool headless = false;				//no graphics card, textures are never loaded, only their images
+	std::vector<TexImage> texImages;	//headless only, what a SoftwareBackend should draw for each texture
 		
-	//load textures, create ship and rocks, set all rocks initially inactive
-	void Init(sf::RenderWindow& window);
+	/*load textures, create ship and rocks, set all rocks initially inactive
+	screenSz - width and height of the screen
+	headless_ - there's no window or graphics card, textures are loaded into texImages instead
+	*/
+	void Init(const sf::Vector2u& screenSz, bool headless_ = false);
+	//load a texture, or just its image when headless
+	void LoadTex(const std::string& file, sf::Texture& tex);
+	//width and height of a texture, from its image when headless
+	sf::Vector2u TexSize(const sf::Texture& tex) const;
 	/*move the ship and rocks, spawn new rocks 
-	window - need it to draw things, get the size of it, etc.
+	screenSz - width and height of the screen
 	elapsed - frame time for any physics code
 	*/
-	void Update(sf::RenderWindow& window, float elapsed, bool fire, char key);
-	//draw everything, called once a frame. Still includes elapsed time incase anything is rotating/scaling
-	void Render(sf::RenderWindow& window, float elapsed);
+	void Update(const sf::Vector2u& screenSz, float elapsed, const InputState& input);
+	/*draw everything, called once a frame. Still includes elapsed time incase anything is rotating/scaling
+	gfx - the window, or memory when running headless
+	withHUD - false if the caller draws the HUD itself, e.g. at a different resolution to the world
+	*/
+	void Render(RenderBackend& gfx, float elapsed, bool withHUD = true);
+	//the frame is finished, throw away everything in frameArena
+	void EndFrame();
+	//make sure the snapshots have room for the bullets in flight now and a few more, only grows them between frames
+	void ReserveSnapshots();
+	/*
+	Write everything the simulation needs to carry on from this moment: objects,
+	particles, spawn timers, score, lives, random numbers and the clock.
+	Textures, fonts and loaded data aren't included, the game must already be set up
+	*/
+	void SaveSnapshot(Snapshot& snap) const;
+	/*go back to a saved moment, every read and index is checked as it may have come from a file
+	returns - false if it came from a different version or setup, or is truncated or corrupt, nothing changes then
+	*/
+	bool LoadSnapshot(Snapshot& snap);
+	//the magic number, version and object count match this game
+	bool ReadSnapshotHeader(Snapshot& snap) const;
+	//everything after the header, false if anything was missing or out of range, the game is left half loaded then
+	bool ReadSnapshot(Snapshot& snap);
+	void QuickSave();
+	bool QuickLoad();
+	//take a rewind snapshot every REWIND_INTERVAL seconds
+	void RecordRewind(float elapsed);
+	//go back to the latest rewind snapshot and drop it, so pressing again goes further back
+	bool Rewind();
 	//randomly put rocks on the screen at the start, quite tricky as they need carefully spacing out
-	//window - so you know how big the space is
+	//so they are placed by Poisson disk sampling, or taken from a pre-generated layout
+	//screenSz - so you know how big the space is
 	//tex - rock texture
-	void PlaceRocks(sf::RenderWindow& window, sf::Texture& tex);
+	//Nothing calls these at the moment, rocks are out of the game (texRock is never loaded and they
+	//don't move), they're kept for when rocks come back. Only -layouts uses the sampler for now
+	void PlaceRocks(const sf::Vector2u& screenSz, sf::Texture& tex);
 	//similar to the above, but used once the game is running to reuse old rocks
-	void PlaceExistingRocks(sf::RenderWindow& window);
+	void PlaceExistingRocks(const sf::Vector2u& screenSz);
 	
 
 	//we need to control what is going on in the game, start->play->die->enterName
 	enum class Mode { INTRO, GAME, GAME_OVER, ENTER_NAME};
 	Mode mode = Mode::INTRO;
+	//the menu screens don't move, they only change when the player does something
+	bool IsStatic() const {
+		return mode != Mode::GAME;
+	}
 
 	//things to render over the game, like scores
-	void RenderHUD(sf::RenderWindow& window, float elapsed, sf::Font & font);
+	void RenderHUD(RenderBackend& gfx, float elapsed, sf::Font & font);
 	//called every time a new game starts to reset everything
-	void NewGame(sf::RenderWindow & window);
+	void NewGame(const sf::Vector2u& screenSz);
 
 	//it's an update function, but only call it when the game is running
 	//as it's going to be the most complex update compared to intro mode and when the game is over
-	void UpdateInGame(sf::RenderWindow & window, float elapsed, bool fire);
+	void UpdateInGame(const sf::Vector2u& screenSz, float elapsed, const InputState& input);
+	/*
+	Update every object, the objects are split into chunks and the chunks shared
+	across the worker threads. Anything that touches another object ends up
+	in cmdBuffers and is done afterwards by ApplyCommands
+	*/
+	void UpdateObjects(const sf::Vector2u& screenSz, float elapsed, const InputState& input);
+	//carry out queued commands in chunk order so the result is always the same
+	void ApplyCommands();
+	//do whatever the scheduler says is due this frame
+	void HandleEvents(const sf::Vector2u& screenSz);
+	/*
+	Work through this frame's contacts in a fixed order, letting each object
+	react to what it hit, then carry out all the damage that causes
+	*/
+	void ResolveContacts();
+	/*
+	A bullet touched an object, like a bullet object's Hit it damages anything
+	not on the side that fired it, and whatever it hits uses it up
+	shot - index into projectiles
+	target - what it hit
+	cmds - damage is queued in here
+	*/
+	void ProjectileHit(int shot, GameObj& target, CmdBuffer& cmds);
+	//turn all the effect requests into emitters in one batch
+	void SpawnEffects();
+	//queue every collision radius (red if touching) and the grid cells in use
+	void DebugDrawCollisions();
+	/*
+	Work out which active objects can be seen, only these are animated and drawn
+	view - the part of the world on screen
+	*/
+	void CullObjects(const sf::FloatRect& view);
 	//separate render function just for the game over screen
-	void RenderGameOver(sf::RenderWindow & window, float elapsed);
+	void RenderGameOver(RenderBackend& gfx, float elapsed);
 };
 
 /*
-Update every object to see if it is colliding with any other - sets the colliding flag true
+Test every object to see if it is colliding with any other, nothing is changed
 objects - any could be colliding
-debug - if true, draw the collision radius and mark any collisions in red
+shots - bullets, these go in the same grid as the objects
+grid - rebuilt with the active objects, only neighbouring cells are tested
+contacts - filled with every touching pair, no particular order, a bullet's id is objects.size() + its index
+pWorkers - optional, the grid rows are shared out as bands across these threads
+pJobs - needed with pWorkers, where each band's contacts go before they are merged
 */
-void CheckCollisions(std::vector<GameObj>& objects, sf::RenderWindow& window, bool debug = true);
-//
-void DrawCircle(sf::RenderWindow& window, const sf::Vector2f& pos, float radius, sf::Color col);
+void CheckCollisions(const std::vector<GameObj>& objects, const Projectiles& shots, CollisionGrid& grid, FrameVector<Contact>& contacts,
+	WorkerPool *pWorkers = nullptr, ContactJobs *pJobs = nullptr);
 /*
 file - path and file name and extension
 tex - set this up with the texture
 */
 bool LoadTexture(const std::string& file, sf::Texture& tex);
 /*
-Check if two circles are touching
+Check if two circles are touching, compares squared distances so there's no square root
 pos1,pos2 - two centres
 minDist - minimum colliding distance
 */
@@ -172,5 +341,13 @@ Look through the objects array, find an inactive rock, pick a new starting posit
 for it just off screen to the right. Check it is at least extraClearance units away
 from anything else and mark active.
 If it does collide with something then don't spawn and return false.
+rng - picks the height it comes in at
+*/
+bool Spawn(GameObj::ObjectT type, const sf::Vector2u& screenSz, std::vector<GameObj>& objects, float extraClearance, Rng& rng);
+/*
+Make rock layouts ahead of time so PlaceRocks can just pick one,
+run the game with -layouts to save some to data/rock_layouts.txt
+area - screen size they are for
+num - how many different layouts to make
 */
-bool Spawn(GameObj::ObjectT type, sf::RenderWindow& window, std::vector<GameObj>& objects, float extraClearance);
+void GenerateRockLayouts(const sf::Vector2u& area, int num, std::vector<DiskLayout>& layouts);
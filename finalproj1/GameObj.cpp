@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <math.h>
 
 #include "GameObj.h"
 #include "Game.h"
@@ -7,194 +8,102 @@
 using namespace sf;
 using namespace std;
 
-/// \param rectLeft   Left coordinate of the rectangle
-	/// \param rectTop    Top coordinate of the rectangle
-	/// \param rectWidth  Width of the rectangle
-	/// \param rectHeight Height of the rectangle
-vector<IntRect> walkframeDefs{
-	{10,20,64,60},
-	{74,20,64,60},
-	{138,20,64,60},
-	{202,20,64,60},
-	{266,20,64,60},
-	{330,20,64,60},
-	{394,20,64,60},
-	{458,20,64,60},
-	//framedefs is the values of the sprites 
-};
-vector<IntRect> idleframeDefs{
-	{518,20,64,60},
-	{582,20,64,60},
-	{646,20,64,60},
-	{710,20,64,60},
-	
-	//framedefs is the values of the sprites 
-};
-vector<IntRect> AttackframeDefs{
-	{783,9,54,65},
-	{856,9,54,65},
-	{929,9,54,65},
-	{999,9,54,65},
-	{1056,9,54,65},
-	{1130,9,54,65},
-	{1210,9,54,65}
-
-	//framedefs is the values of the sprites 
-};
-
-
-struct AnimSpritewalk {
-	Sprite spr;
-	
-	float lastFrameSkip = 0;
-	int frameIdx = 0;
-	bool play = false;
-
-	void Updatechar(float dT)
-	{
-		lastFrameSkip += dT;
-		if (lastFrameSkip > 1.f / 8.f) {
-			lastFrameSkip = 0;
-			frameIdx++;
-			if (frameIdx > 7)
-				frameIdx = 0;
-		}
-		
-	}
-
-	void Render()
-	{
-		
-	}
-};
-struct AnimSpriteidle {
-	Sprite spr;
-
-	float lastFrameSkip = 0;
-	int frameIdx = 0;
-	bool play = false;
-
-	void Updatechar(float dT)
-	{
-		lastFrameSkip += dT;
-		if (lastFrameSkip > 1.f / 8.f) {
-			lastFrameSkip = 0;
-			frameIdx++;
-			if (frameIdx > 3)
-				frameIdx = 0;
-		}
-
-	}
-
-	void Render()
-	{
-
-	}
-};
-struct AnimSpriteatk {
-	Sprite spr;
-
-	float lastFrameSkip = 0;
-	int frameIdx = 0;
-	bool play = false;
-
-	void Updatechar(float dT)
-	{
-		lastFrameSkip += dT;
-		if (lastFrameSkip > 1.f / 8.f) {
-			lastFrameSkip = 0;
-			frameIdx++;
-			if (frameIdx > 6)
-				frameIdx = 0;
-		}
-
-	}
-
-	void Render()
-	{
-
-	}
-};
-AnimSpritewalk walkAnim;
-AnimSpriteidle idleAnim;
-AnimSpriteatk atckAnim;
-void GameObj::InitChar(RenderWindow& window, Texture& tex)
+void GameObj::InitChar(const Vector2u& screenSz, Texture& tex)
 {	
 	
 	
+	assert(pGame);
 	spr.setTexture(tex, true);
-	const IntRect& texRect = idleframeDefs[0];
-	spr.setTextureRect(idleframeDefs[0]);//sets thevalues of the sprite sheet to the 1st sprite 
+	pGame->animSys.Play(anim, pGame->animSys.GetId(AnimSys::ClipT::KnightIdle));
+	const IntRect& texRect = pGame->animSys.GetFrame(anim);
+	spr.setTextureRect(texRect);//sets thevalues of the sprite sheet to the 1st sprite 
 	spr.setOrigin(texRect.width/2, texRect.height / 7.5f);
 	spr.setScale(-3.f, 3.f);
 	spr.setRotation(0);
 	type = ObjectT::player;
 }
 
-void GameObj::ResetShip(RenderWindow& window)
+void GameObj::ResetShip(const Vector2u& screenSz)
 {
 	health = 3;
 	active = true;
-	spr.setPosition(spr.getGlobalBounds().width*0.6f, window.getSize().y / 2.f);
+	spr.setPosition(spr.getGlobalBounds().width*0.6f, screenSz.y / 2.f);
 }
 void charidle()
 {
 	
 }
 
-void GameObj::Initbckgd(RenderWindow& window, Texture& tex)
+void GameObj::Initbckgd(const Vector2u& screenSz, Texture& tex)
 {
 	spr.setTexture(tex, true);
-	spr.setOrigin(window.getSize().x / 2.f, window.getSize().y / 2.f);
+	spr.setOrigin(screenSz.x / 2.f, screenSz.y / 2.f);
 	spr.setRotation(0);
-	spr.setScale(window.getSize().x, window.getSize().y);
+	spr.setScale(screenSz.x, screenSz.y);
 	type = ObjectT::Background;
 
 }
 
+void GameObj::InitRock(const Vector2u& screenSz, Texture& tex)
+{
+	spr.setTexture(tex, true);
+	const IntRect& texRect = spr.getTextureRect();
+	spr.setOrigin(texRect.width / 2.f, texRect.height / 2.f);
+	spr.setRotation(0);
+	radius = texRect.width / 2.f;
+	active = false;
+	type = ObjectT::Rock;
+	health = 0;
+}
+
 void GameObj::ResetRock()
 {
 	//health = (int)(5.f * spr.getScale().x);
 }
 
-void GameObj::InitEnemy(RenderWindow& window, Texture& tex)
+void GameObj::InitEnemy(const Vector2u& screenSz, Texture& tex)
 {
+	assert(pGame);
+	spr.setTexture(tex, true);
+	pGame->animSys.Play(anim, pGame->animSys.GetId(AnimSys::ClipT::Ghost));
+	const IntRect& texRect = pGame->animSys.GetFrame(anim);
+	spr.setTextureRect(texRect);
+	spr.setOrigin(texRect.width / 2.f, texRect.height / 2.f);
+	radius = texRect.width / 2.f;
+	active = false;
+	type = ObjectT::Enemy;
+	health = 0;
 }
 
 void GameObj::ResetEnemy()
 {
+	assert(pGame);
+	thrust = Vector2f(0, 0);
+	//first shot a little while after turning up, spread out so they don't all fire together
+	float wait = GC::ENEMY_FIRE_DELAY * (1.f + pGame->rng.Range(100) / 100.f);
+	pGame->scheduler.Cancel(timerId);
+	timerId = pGame->scheduler.Schedule(pGame->simTime + wait, GameEvent{ GameEvent::EvT::EnemyFire, (unsigned int)(this - pGame->objects.data()) });
 }
 
 
-void GameObj::InitBullet(RenderWindow& window, Texture& tex)
-{
-	spr.setTexture(tex);
-	IntRect texR(0, 0, 32, 32);
-	spr.setTextureRect(texR);
-	spr.setOrigin(texR.width / 2.f, texR.height / 2.f);
-	radius = 5.f;
-	float scale = 0.5f;
-	spr.setScale(scale, scale);
-	active = false;
-	type = ObjectT::Bullet;
-	health = 0;
-}
-
-void GameObj::Init(RenderWindow& window, Texture& tex, ObjectT type_, Game& game)
+void GameObj::Init(const Vector2u& screenSz, Texture& tex, ObjectT type_, Game& game)
 {
  	pGame = &game;
 	switch (type_)
 	
 	{
 	case ObjectT::player:
- 		InitChar(window, tex);
+ 		InitChar(screenSz, tex);
 		break;
 	
-	case ObjectT::Bullet:
-		InitBullet(window, tex);
+	case ObjectT::Enemy:
+		InitEnemy(screenSz, tex);
+		break;
+	case ObjectT::Rock:
+		InitRock(screenSz, tex);
 		break;
 	case ObjectT::Background:
-		Initbckgd(window, tex);
+		Initbckgd(screenSz, tex);
 		break;
 	
 	default:
@@ -202,7 +111,7 @@ void GameObj::Init(RenderWindow& window, Texture& tex, ObjectT type_, Game& game
 	}
 }
 
-void GameObj::Update(RenderWindow& window, float elapsed, bool fire)
+void GameObj::Update(const Vector2u& screenSz, float elapsed, const InputState& input, CmdBuffer& cmds)
 {
 	if (active)
 	{
@@ -210,17 +119,14 @@ void GameObj::Update(RenderWindow& window, float elapsed, bool fire)
 		switch (type)
 		{
 		case ObjectT::player:
-			PlayerControl(window.getSize(), elapsed, fire);
+			PlayerControl(screenSz, elapsed, input, cmds);
 			break;
 		case ObjectT::Rock:
 			MoveRock(elapsed);
 			break;
-		case ObjectT::Bullet:
-			MoveBullet(window.getSize(), elapsed);
-			break;
 		case ObjectT::Enemy:
-			EnemyShoot(elapsed);
-			MoveEnemy(window.getSize(), elapsed);
+			//firing is done by the scheduler, see EnemyShoot
+			MoveEnemy(screenSz, elapsed);
 			break;
 		}
 	}
@@ -236,40 +142,29 @@ void GameObj::MoveRock(float elapsed)
 	spr.setPosition(x, pos.y);*/
 }
 
-void GameObj::EnemyShoot(float elapsed)
+void GameObj::EnemyShoot()
 {
+	assert(pGame);
+	timerId = TimerId{};	//that was the event that called us
+	if (!active)
+		return;
+	const Vector2f& pos = spr.getPosition();
+	FireBullet(Vector2f(pos.x - spr.getGlobalBounds().width / 2.f, pos.y));
+	timerId = pGame->scheduler.Schedule(pGame->simTime + GC::ENEMY_FIRE_DELAY, GameEvent{ GameEvent::EvT::EnemyFire, (unsigned int)(this - pGame->objects.data()) });
 }
 
 
 void GameObj::MoveEnemy(const sf::Vector2u& screenSz, float elapsed)
 {
-	//where is the player?
 	assert(pGame);
+	//the flow field knows the way to the player, ease round to it rather than snapping
+	Vector2f want = pGame->flowField.Steer(spr.getPosition()) * GC::ENEMY_SPEED;
+	thrust += (want - thrust) * min(1.f, GC::ENEMY_TURN * elapsed);
+	spr.move(thrust * elapsed);
 }
 
 
-void GameObj::MoveBullet(const sf::Vector2u& screenSz, float elapsed)
-{
-	
-	const Vector2f& pos = spr.getPosition();
-	float x;
-	if (pMySpawner && pMySpawner->type == ObjectT::player)
-	{
-		x = pos.x + 250 * elapsed;
-		if (x > (screenSz.x + spr.getGlobalBounds().width / 2.f))
-			active = false;
-	}
-	else
-	{
-		x = pos.x - GC::ENEMY_BULLET_SPEED * elapsed;
-		if (x < 0)
-			active = false;
-	}
-	spr.setPosition(x, pos.y);
-}
-
-
-void GameObj::Render(RenderWindow& window, float elapsed)
+void GameObj::Render(RenderBackend& gfx, float elapsed)
 {
 	
 	
@@ -278,7 +173,7 @@ void GameObj::Render(RenderWindow& window, float elapsed)
 	{
 	
 		
-		window.draw(spr);
+		gfx.Draw(spr);
 			
 	}
 	
@@ -303,48 +198,37 @@ Vector2f Decay(Vector2f& currentVal, float pcnt, float timeInterval, float dTime
 	return alpha;
 }
 
-void GameObj::PlayerControl(const Vector2u& screenSz, float elapsed,bool fire)
+void GameObj::PlayerControl(const Vector2u& screenSz, float elapsed, const InputState& input, CmdBuffer& cmds)
 {
+	assert(pGame);
 	Vector2f pos = spr.getPosition();
 	const float SPEED = 250.f;
 	FloatRect rect = spr.getGlobalBounds();
 
-	static Vector2f thrust{ 0,0 };
-
-	
-	
-		
-	if (Keyboard::isKeyPressed(Keyboard::Left)) 
+	const AnimSys& anims = pGame->animSys;
+	bool fire = input.WasReleased(Keyboard::Space);
+	if (input.IsDown(Keyboard::Left)) 
 	{
 		thrust.x = -SPEED;
 		spr.setScale(3.f, 3.f);//changes direction depending of the direction of movement 
-		walkAnim.Updatechar(elapsed);
-		spr.setTextureRect(walkframeDefs[walkAnim.frameIdx]);
+		anims.Play(anim, anims.GetId(AnimSys::ClipT::KnightWalk));
 	}
-	else if (Keyboard::isKeyPressed(Keyboard::Right))
+	else if (input.IsDown(Keyboard::Right))
 	{
 		thrust.x = SPEED;
 		spr.setScale(-3.f, 3.f);//changes direction depending of the direction of movement 
-		walkAnim.Updatechar(elapsed);
-		spr.setTextureRect(walkframeDefs[walkAnim.frameIdx]);
+		anims.Play(anim, anims.GetId(AnimSys::ClipT::KnightWalk));
 	}
-			
-		////cycles the sprite sheet to make an animation
-	
-	
-	else if (Keyboard::isKeyPressed(Keyboard::R))
+	else if (input.IsDown(Keyboard::R))
 	{
-		atckAnim.Updatechar(elapsed);
-	    spr.setTextureRect(AttackframeDefs[atckAnim.frameIdx]);
+		anims.Play(anim, anims.GetId(AnimSys::ClipT::KnightAttack));
 		fire = true;
-		
-		
 	}
 	else
 	{ 
-		idleAnim.Updatechar(elapsed);
-		spr.setTextureRect(idleframeDefs[idleAnim.frameIdx]);
-    }
+		anims.Play(anim, anims.GetId(AnimSys::ClipT::KnightIdle));
+	}
+	//the frames themselves are advanced for every object at once by AnimSys::Update
 
 	pos += thrust * elapsed;
 	thrust = Decay(thrust, 0.1f, 0.02f, elapsed);
@@ -362,142 +246,83 @@ void GameObj::PlayerControl(const Vector2u& screenSz, float elapsed,bool fire)
 
 	if (fire)
 	{
-		Vector2f pos(pos.x + spr.getGlobalBounds().width / 2.f, pos.y);
-		FireBullet(pos);
+		GameCmd cmd;
+		cmd.type = GameCmd::CmdT::FireBullet;
+		cmd.pObj = this;
+		cmd.pos = Vector2f(pos.x + spr.getGlobalBounds().width / 2.f, pos.y);
+		cmds.push_back(cmd);
 	}
 }
 
 void GameObj::FireBullet(const Vector2f& pos)
 {
 	assert(pGame);
-	size_t idx = 0;
-	bool found = false;
-	while (idx < pGame->objects.size() && !found)
+	Projectiles& shots = pGame->projectiles;
+	const int me = (int)(this - pGame->objects.data());
+	if (type == ObjectT::player)
 	{
-		if (!pGame->objects[idx].active && pGame->objects[idx].type == ObjectT::Bullet)
-			found = true;
-		else
-			++idx;
-	}
-	if (idx < pGame->objects.size())
-	{
-		GameObj& bullet = pGame->objects[idx];
-		bullet.active = true;
-		bullet.spr.setPosition(pos);
-		if (type == ObjectT::player)
-			bullet.spr.setColor(Color(128, 128, 255, 255));
-		else
-			bullet.spr.setColor(Color(255, 128, 128, 255));
-		bullet.pMySpawner = this;
+		shots.Fire(pos, Vector2f(GC::BULLET_SPEED, 0), Layer::PlayerBullet, me);
+		return;
 	}
-}
-
-void EnemySplash(Game& game, const Vector2f& pos)
-{
-	Emitter* em = game.particleSys.GetNewEmitter();
-	if (em)
+	//enemies spray a fan of shots to the left
+	for (int i = 0; i < GC::ENEMY_SHOTS; ++i)
 	{
-		em->numToEmit = 500;
-		em->numAtOnce = 10;
-		em->pos = pos;
-		em->rate = 0.001f;
-		em->colour = Color(90, 20, 20, 255);
-		em->scale = Vector2f{ 0.25f,0.25f };
-		em->life = 0.75f;
-		em->initSpeed = Dim2Di{ 50,75 };
-		em->initVel = Vector2f(0, 0);
+		float t = (GC::ENEMY_SHOTS > 1) ? (float)i / (GC::ENEMY_SHOTS - 1) - 0.5f : 0.f;
+		float angle = GC::PI + t * GC::ENEMY_SPREAD;
+		shots.Fire(pos, Vector2f(cosf(angle), sinf(angle)) * GC::ENEMY_BULLET_SPEED, Layer::EnemyBullet, me);
 	}
 }
 
-
-void BulletSplash(Game& game, const Vector2f& pos, const Vector2f& initVel)
+/*
+Damage is never done straight away, it's queued and applied once
+every object has had a look at what it hit this frame
+*/
+void QueueDamage(CmdBuffer& cmds, GameObj& target, int amount, GameObj& from)
 {
-	Emitter* em = game.particleSys.GetNewEmitter();
-	if (em)
-	{
-		em->numToEmit = 30;
-		em->numAtOnce = 30;
-		em->pos = pos;
-		em->rate = 0.001f;
-		em->colour = Color(128, 50, 50, 255);
-		em->scale = Vector2f{ 0.15f,0.15f };
-		em->life = 0.25f;
-		em->initSpeed = Dim2Di{ 15,20 };
-		em->initVel = initVel;
-	}
+	GameCmd cmd;
+	cmd.type = GameCmd::CmdT::TakeDamage;
+	cmd.pObj = &target;
+	cmd.pOther = &from;
+	cmd.pos = from.spr.getPosition();
+	cmd.amount = amount;
+	cmds.push_back(cmd);
 }
 
-void RockExplode(Game& game, const Vector2f& pos, float radius)
+void GameObj::Hit(GameObj& other, CmdBuffer& cmds)
 {
-	Emitter* em = game.particleSys.GetNewEmitter();
-	if (em)
-	{
-		em->numToEmit = 500;
-		em->numAtOnce = 20;
-		em->pos = pos;
-		em->rate = 0.001f;
-		em->colour = Color(10, 10, 19, 255);
-		float sizeMult = (radius / GC::ROCK_RAD.y) * 2;
-		em->scale = Vector2f{ 0.5f,0.5f };
-		em->life = 1.f;
-		em->initSpeed.y = 25 + (int)(50 * sizeMult);
-		em->initSpeed.x = (int)(em->initSpeed.y * 0.5f);
-		em->initVel = Vector2f{ 0,0 };
-	}
-}
-
-void ShipExplode(Game& game, const Vector2f& pos, const Vector2f& initVel)
-{
-	Emitter* em = game.particleSys.GetNewEmitter();
-	if (em)
+	switch (type)
 	{
-		em->numToEmit = 1000;
-		em->numAtOnce = 50;
-		em->pos = pos;
-		em->rate = 0.001f;
-		em->colour = Color(10, 20, 20, 255);
-		em->scale = Vector2f{ 0.5f,0.75f };
-		em->life = 1.f;
-		em->initSpeed = Dim2Di{ 50,350 };
-		em->initVel = initVel;
+	case ObjectT::player:
+		QueueDamage(cmds, other, 999, *this);
+		break;
+	case ObjectT::Rock:
+		QueueDamage(cmds, other, 1, *this);
+		break;
+	case ObjectT::Enemy:
+		QueueDamage(cmds, other, 1, *this);
+		break;
+	default:
+		assert(false);
 	}
 }
 
-void GameObj::Hit(GameObj& other)
+Layer GameObj::GetLayer() const
 {
 	switch (type)
 	{
 	case ObjectT::player:
-		{
-			bool spawnedByMe = other.pMySpawner && other.pMySpawner->type == type;
-			if (!spawnedByMe)
-				other.TakeDamage(999, *this);
-			break;
-		}
-	case ObjectT::Bullet:
-		{
-			bool spawnedByOther = pMySpawner->type == other.type;
-			if (!spawnedByOther && other.type!=ObjectT::Bullet)
-				other.TakeDamage(1, *this);
-			break;
-		}
+		return Layer::Player;
 	case ObjectT::Rock:
-		other.TakeDamage(1, *this);
-		break;
+		return Layer::Rock;
 	case ObjectT::Enemy:
-		{
-			//ignore things I spawned
-			bool spawnedByMe = other.pMySpawner && other.pMySpawner->type == type;
-			if (!spawnedByMe)
-				other.TakeDamage(1, *this);
-			break;
-		}
+		return Layer::Enemy;
 	default:
 		assert(false);
+		return Layer::Rock;
 	}
 }
 
-void GameObj::TakeDamage(int amount, GameObj& other)
+void GameObj::TakeDamage(int amount, const Vector2f& from)
 {
 	assert(pGame);
 	if (type == ObjectT::Enemy)
@@ -505,23 +330,73 @@ void GameObj::TakeDamage(int amount, GameObj& other)
 
 	health -= amount;
 	if (health <= 0)
+	{
 		active = false;
+		pGame->scheduler.Cancel(timerId);
+	}
 
 	switch (type)
 	{
 	case ObjectT::player:
-		ShipExplode(*pGame, spr.getPosition(), Vector2f{ 0,0 });
+		pGame->effectReqs.push_back(EffectReq{ EffectT::ShipExplode, spr.getPosition(), Vector2f{ 0,0 }, radius });
 		assert(pGame);
 		pGame->metrics.lives--;
 		break;
-	case ObjectT::Bullet:
-  		BulletSplash(*pGame, spr.getPosition(), Vector2f{ -GC::ROCK_SPEED,0 });
-		break;
 	case ObjectT::Rock:
 		if (health <= 0)
-			RockExplode(*pGame, other.spr.getPosition(), radius);
+			pGame->effectReqs.push_back(EffectReq{ EffectT::RockExplode, from, Vector2f{ 0,0 }, radius });
 		break;
 	default:
 		assert(false);
 	}
 }
+
+void GameObj::Save(Snapshot& snap) const
+{
+	snap.Write(type);
+	snap.Write(active);
+	snap.Write(colliding);
+	snap.Write(health);
+	snap.Write(bga);
+	snap.Write(radius);
+	snap.Write(anim);
+	snap.Write(thrust);
+	snap.Write(timerId);
+	snap.Write(spr.getPosition());
+	snap.Write(spr.getRotation());
+	snap.Write(spr.getScale());
+	snap.Write(spr.getOrigin());
+	snap.Write(spr.getTextureRect());
+	snap.Write(spr.getColor());
+}
+
+void GameObj::Load(Snapshot& snap)
+{
+	snap.Read(type);
+	if (type > ObjectT::Background)
+		snap.Fail();
+	snap.Read(active);
+	snap.Read(colliding);
+	snap.Read(health);
+	snap.Read(bga);
+	snap.Read(radius);
+	snap.Read(anim);
+	snap.Read(thrust);
+	snap.Read(timerId);
+	Vector2f pos, scale, origin;
+	float rotation;
+	IntRect texRect;
+	Color col;
+	snap.Read(pos);
+	snap.Read(rotation);
+	snap.Read(scale);
+	snap.Read(origin);
+	snap.Read(texRect);
+	snap.Read(col);
+	spr.setPosition(pos);
+	spr.setRotation(rotation);
+	spr.setScale(scale);
+	spr.setOrigin(origin);
+	spr.setTextureRect(texRect);
+	spr.setColor(col);
+}
@@ -3,8 +3,28 @@
 
 #include "SFML/Graphics.hpp"
 #include "Utils.h"
+#include "Anim.h"
+#include "ParticleSys.h"
+#include "Input.h"
+#include "Collision.h"
+#include "Scheduler.h"
 
 struct Game;
+struct GameObj;
+
+/*
+Anything an object wants to do to another object while objects are updating in
+parallel gets written down as a command and carried out afterwards on one thread
+*/
+struct GameCmd {
+	enum class CmdT { FireBullet, TakeDamage };
+	CmdT type;
+	GameObj *pObj = nullptr;	//who fires, or who takes the damage
+	GameObj *pOther = nullptr;	//who did the damage
+	sf::Vector2f pos;			//where to fire from, or where the damage came from
+	int amount = 0;				//how much damage
+};
+typedef std::vector<GameCmd> CmdBuffer;	//one per chunk of objects being updated
 
 /*
 A game object is anything represented by a sprite that exists in the game world
@@ -15,82 +35,92 @@ struct GameObj
 	sf::Sprite spr;	//main image
 	sf::Sprite bg;
 	float radius = 0;				//collision radius
-	enum class ObjectT { player, Rock, Bullet, Enemy,Background };	//what is this object instance?
+	enum class ObjectT { player, Rock, Enemy,Background };	//what is this object instance?
 	ObjectT type = ObjectT::Rock;	//what type am I?	
 	bool colliding = false;			//did we hit something on the last update
 	bool active = false;			//should we be updating and rendering this one?
 	int health = 0;					//if it's zero then I'm dead
 	Game *pGame = nullptr;			//keep a pointer (a handle) to my owner the game object
-	GameObj *pMySpawner = nullptr;
 	bool bga = false;	//if I am a bullet, then some other object fired me off (player or enemy?)
+	AnimState anim;		//which animation clip is playing and how far through it we are
+	sf::Vector2f thrust{ 0,0 };	//player movement that decays away when the keys are let go, an enemy's velocity
+	TimerId timerId;			//my event waiting on the scheduler, e.g. when an enemy fires next
 
 	/*
 	Call this to setup your object
-	window - sfml render window
+	screenSz - width and height of the screen
 	tex - texture to use on the sprite
 	type - what is it meant to be
 	game - a reference to our owner the game itself
 	*/
-	void Init(sf::RenderWindow& window, sf::Texture& tex, ObjectT type_, Game& game);
+	void Init(const sf::Vector2u& screenSz, sf::Texture& tex, ObjectT type_, Game& game);
 	/*called by Init as needed
-	window - sfml render window
+	screenSz - width and height of the screen
 	tex - player ship texture
 	*/
-	void InitChar(sf::RenderWindow& window, sf::Texture& tex);
+	void InitChar(const sf::Vector2u& screenSz, sf::Texture& tex);
 	/*Called when we want to start, reset various player ship data
-	windows - sfml render window
+	screenSz - width and height of the screen
 	*/
-	void ResetShip(sf::RenderWindow& window);
+	void ResetShip(const sf::Vector2u& screenSz);
 	//called by Init as needed, like InitShip but for rocks
-	void InitRock(sf::RenderWindow& window, sf::Texture& tex);
+	void InitRock(const sf::Vector2u& screenSz, sf::Texture& tex);
 	//like resetShip(), if we want a new rock, we call this to reset variables
 	void ResetRock();
 	//These two are like the others but for enemy ships
-	void InitEnemy(sf::RenderWindow& window, sf::Texture& tex);
+	void InitEnemy(const sf::Vector2u& screenSz, sf::Texture& tex);
 	void ResetEnemy();
-	void Initbckgd(sf::RenderWindow& window, sf::Texture& tex);
-	/*move and update logic
+	void Initbckgd(const sf::Vector2u& screenSz, sf::Texture& tex);
+	/*move and update logic, safe to call on different objects from different threads
 	*
-	window - usual render window
+	screenSz - width and height of the screen
 	elapsed - physics simulation needs frame time 1/60th a second or similar
-	fire - did the player want to shoot
+	input - what the player is pressing this frame
+	cmds - anything that affects another object goes in here to be done later
 	*/
-	
-	void Update(sf::RenderWindow& window, float elapsed, bool fire);
+	void Update(const sf::Vector2u& screenSz, float elapsed, const InputState& input, CmdBuffer& cmds);
 	//draw yourself
-	//need the window to draw and elapsed time might be needed if there's any motion or spinning or scaling
-	void Render(sf::RenderWindow& window, float elapsed);
+	//need somewhere to draw and elapsed time might be needed if there's any motion or spinning or scaling
+	void Render(RenderBackend& gfx, float elapsed);
 	/*handle moving the ship around
 	screenSz - width and height of the screen
 	elapsed - frame time
-	fire - let off a bullet
+	input - arrow keys move, space or R lets off a bullet
+	cmds - firing is queued in here
 	*/
-	void PlayerControl(const sf::Vector2u& screenSz, float elapsed, bool fire);
+	void PlayerControl(const sf::Vector2u& screenSz, float elapsed, const InputState& input, CmdBuffer& cmds);
 	//rocks all move left, when leave the left edge of the screen they deactivate
 	//elapsed time is needed for smooth motion
 	void MoveRock(float elapsed);
 
-	//these three functions are similar, but specifically for bullets which 
-	//simply fly to the right/left and go to sleep if they leave the screen
-	//if they are spawn by a player go right, if an enemy then go left
-	void MoveBullet(const sf::Vector2u& screenSz, float elapsed);
-	void InitBullet(sf::RenderWindow& window, sf::Texture& tex);
+	//bullets fly to the right if the player fired them, left if an enemy did.
+	//They live in Game::projectiles, not as objects
+	//pos - where to fire from, enemies fire a fan of ENEMY_SHOTS
 	void FireBullet(const sf::Vector2f& pos);
 
-	//similar again, enemies fly to the left
+	//enemies home in on the player, each one just looks up its heading in Game::flowField
 	void MoveEnemy(const sf::Vector2u& screenSz, float elapsed);
-	//enemies fire bullets too, but need timers to slow firing down so it isn't too hard
-	void EnemyShoot(float elapsed);
+	/*
+	enemies fire bullets too, but need timers to slow firing down so it isn't too hard,
+	called by the scheduler when the cooldown is up, then sets up the next one
+	*/
+	void EnemyShoot();
 
 	/*what should an object do if it hits another object, for example, a bullet hitting an enemy
 	other - the other object it hit
+	cmds - any damage is queued in here
 	*/
-	void Hit(GameObj& other);
+	void Hit(GameObj& other, CmdBuffer& cmds);
 	/*After taking a hit we might decide we need to take some damage
 	so if an asteroid takes so much damage it dies then it needs to explode and disappear
 	amount - how much damage
-	other - the other object doing damage to us
+	from - where the damage came from, e.g. a rock explodes where the bullet hit it
 	*/
-	void TakeDamage(int amount, GameObj& other);
+	void TakeDamage(int amount, const sf::Vector2f& from);
+	//which collision layer I'm in
+	Layer GetLayer() const;
+	//Write everything about me that changes while the game is running
+	void Save(Snapshot& snap) const;
+	//undo Save, pGame and the texture are left alone as they never change
+	void Load(Snapshot& snap);
 };
-
@@ -0,0 +1,87 @@
+#include "Input.h"
+
+using namespace sf;
+using namespace std;
+
+void InputState::BeginFrame()
+{
+	pressed.reset();
+	released.reset();
+	text.clear();
+	quit = false;
+	changed = false;
+}
+
+void InputState::Handle(const Event& event)
+{
+	switch (event.type)
+	{
+	case Event::Closed:
+		quit = true;
+		break;
+	case Event::KeyPressed:
+		if (event.key.code >= 0 && event.key.code < Keyboard::KeyCount)
+		{
+			if (!down[event.key.code])
+				pressed[event.key.code] = true;
+			down[event.key.code] = true;
+		}
+		if (event.key.code == Keyboard::Escape)
+			quit = true;
+		break;
+	case Event::KeyReleased:
+		if (event.key.code >= 0 && event.key.code < Keyboard::KeyCount)
+		{
+			down[event.key.code] = false;
+			released[event.key.code] = true;
+		}
+		break;
+	case Event::TextEntered:
+		if (event.text.unicode < 128)
+			text += static_cast<char>(event.text.unicode);
+		break;
+	case Event::LostFocus:
+		//we won't hear about anything let go while we're in the background
+		down.reset();
+		break;
+	default:
+		break;
+	}
+	switch (event.type)
+	{
+	case Event::Closed:
+	case Event::KeyPressed:
+	case Event::KeyReleased:
+	case Event::TextEntered:
+	case Event::Resized:
+	case Event::GainedFocus:
+		changed = true;
+		break;
+	default:
+		break;
+	}
+}
+
+void InputState::Write(ostream& os) const
+{
+	os << down << ' ' << pressed << ' ' << released << ' ' << quit << ' ' << text.size();
+	for (size_t i = 0; i < text.size(); ++i)
+		os << ' ' << (int)(unsigned char)text[i];
+	os << '\n';
+}
+
+bool InputState::Read(istream& is)
+{
+	size_t len = 0;
+	if (!(is >> down >> pressed >> released >> quit >> len))
+		return false;
+	text.resize(len);
+	for (size_t i = 0; i < len; ++i)
+	{
+		int c;
+		if (!(is >> c))
+			return false;
+		text[i] = (char)c;
+	}
+	return true;
+}
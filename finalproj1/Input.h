@@ -0,0 +1,43 @@
+#pragma once
+#include <bitset>
+#include <string>
+#include <iostream>
+
+#include "SFML/Graphics.hpp"
+
+/*
+Everything the player did with the keyboard, gathered up once a frame
+from the window events so nothing else has to ask the OS. Keys are kept
+as bits, so a frame of input is small enough to record and play back
+*/
+struct InputState {
+	typedef std::bitset<sf::Keyboard::KeyCount> Keys;
+	Keys down;			//keys held at the end of the frame
+	Keys pressed;		//went down this frame, key repeat doesn't count
+	Keys released;		//came up this frame
+	std::string text;	//characters typed this frame, including backspaces ('\b')
+	bool quit = false;	//window closed or escape pressed
+	bool changed = false;	//any event this frame that could change what's on screen (keys, text, resizing, focus, closing)
+
+	//forget this frame's edges and text, keys held stay held
+	void BeginFrame();
+	//update the snapshot with one event from pollEvent
+	void Handle(const sf::Event& event);
+	bool IsDown(sf::Keyboard::Key key) const {
+		return down[key];
+	}
+	bool WasPressed(sf::Keyboard::Key key) const {
+		return pressed[key];
+	}
+	bool WasReleased(sf::Keyboard::Key key) const {
+		return released[key];
+	}
+	//pretend key went down and up again this frame, e.g. for scripted tests
+	void Tap(sf::Keyboard::Key key) {
+		pressed[key] = released[key] = true;
+		changed = true;
+	}
+	//one line of text per frame, Read undoes Write
+	void Write(std::ostream& os) const;
+	bool Read(std::istream& is);
+};
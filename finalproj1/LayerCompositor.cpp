@@ -0,0 +1,42 @@
+#include <assert.h>
+
+#include "LayerCompositor.h"
+
+using namespace sf;
+using namespace std;
+
+//make the texture if it isn't already this size, what was in it is lost
+static void MakeTex(LayerCompositor::Layer& l, const Vector2u& size)
+{
+	if (l.size == size)
+		return;
+	if (!l.tex.create(size.x, size.y))
+		assert(false);
+	l.size = size;
+	l.valid = false;
+	//the texture object is the same but it's a different size now
+	l.spr.setTexture(l.tex.getTexture(), true);
+}
+
+bool LayerCompositor::Prepare(Layer& l, const Vector2u& size, size_t key)
+{
+	if (l.valid && l.key == key && l.size == size)
+		return true;
+	MakeTex(l, size);
+	l.tex.clear(Color::Transparent);
+	l.key = key;
+	l.valid = false;
+	return false;
+}
+
+void LayerCompositor::InvalidateAll()
+{
+	for (int i = 0; i < (int)LayerT::COUNT; ++i)
+		layers[i].valid = false;
+}
+
+void LayerCompositor::Resize(const Vector2u& size)
+{
+	for (int i = 0; i < (int)LayerT::COUNT; ++i)
+		MakeTex(layers[i], size);
+}
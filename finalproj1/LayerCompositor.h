@@ -0,0 +1,73 @@
+#pragma once
+#include "SFML/Graphics.hpp"
+#include "RenderBackend.h"
+
+/*
+Parts of the picture that hardly ever change (the background, the menu
+screens, one day static level tiles) are drawn once into their own off
+screen texture and after that each frame is just one quad per layer. A
+layer is drawn again when what's in it changes, which the caller says by
+passing a different key, or when the screen changes size.
+Caching needs a GPU render target, anything else (the software renderer,
+a recorded RenderFrame) just has the layer drawn straight into it every time
+*/
+struct LayerCompositor {
+	enum class LayerT { Background, Menu, COUNT };
+	struct Layer {
+		sf::RenderTexture tex;
+		sf::Sprite spr;			//the whole texture, drawn at 0,0
+		sf::Vector2u size;		//tex is this big, zero if it was never made
+		size_t key = 0;			//what the caller said was in it
+		bool valid = false;		//false if it needs drawing before it can be used
+	};
+	Layer layers[(int)LayerT::COUNT];
+	int hits = 0;		//frames a layer was drawn from its texture
+	int redraws = 0;	//times a layer had to be drawn again
+	int uncached = 0;	//layers drawn straight to a target that can't cache
+
+	/*
+	Put a layer on screen, only drawing its contents if they've changed
+	gfx - where the frame is being drawn
+	layer - which one
+	key - anything that says what's in the layer, e.g. which menu, a different key means draw it again
+	draw - called with somewhere to draw the contents when that's needed
+	*/
+	template<typename FN>
+	void Draw(RenderBackend& gfx, LayerT layer, size_t key, FN draw)
+	{
+		sf::RenderTarget *pTarget = gfx.GetTarget();
+		if (!pTarget)
+		{
+			++uncached;
+			draw(gfx);
+			return;
+		}
+		Layer& l = layers[(int)layer];
+		if (!Prepare(l, gfx.GetSize(), key))
+		{
+			SFMLBackend layerGfx(l.tex);
+			draw(layerGfx);
+			l.tex.display();
+			l.valid = true;
+			++redraws;
+		}
+		else
+			++hits;
+		gfx.Draw(l.spr);
+	}
+	/*
+	Get a layer ready to use, making its texture if the size changed
+	returns - true if what's already in it can be used, false if it's been cleared and needs drawing
+	*/
+	bool Prepare(Layer& l, const sf::Vector2u& size, size_t key);
+	//the next Draw of this layer will draw its contents again
+	void Invalidate(LayerT layer) {
+		layers[(int)layer].valid = false;
+	}
+	void InvalidateAll();
+	/*
+	Remake every layer's texture for a new screen size so Draw doesn't have to
+	in the middle of a frame, layers are drawn again the next time they're used
+	*/
+	void Resize(const sf::Vector2u& size);
+};
@@ -1,4 +1,7 @@
 #include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
 
 #include "ParticleSys.h"
 #include "Game.h"
@@ -6,16 +9,37 @@
 using namespace std;
 using namespace sf;
 
-void Particles::Init() {
-	LoadTexture("data/circle.png", texSprite);
+void Particles::MakeDot(Image& img) {
+	const unsigned int sz = GC::PARTICLE_DOT;
+	img.create(sz, sz, Color::Transparent);
+	const float r = sz / 2.f;
+	for (unsigned int y = 0; y < sz; ++y)
+		for (unsigned int x = 0; x < sz; ++x) {
+			//fades out towards the edge
+			float dx = (x + 0.5f - r) / r, dy = (y + 0.5f - r) / r;
+			float a = 1.f - sqrtf(dx * dx + dy * dy);
+			if (a > 0)
+				img.setPixel(x, y, Color(255, 255, 255, (Uint8)(255 * min(a * 2.f, 1.f))));
+		}
+}
+
+void Particles::Init(int numParticles, bool loadTexture) {
+	if (loadTexture) {
+		Image img;
+		MakeDot(img);
+		if (!texSprite.loadFromImage(img))
+			assert(false);
+		texSprite.setSmooth(true);
+	}
 	Particle p;
 	p.spr.setTexture(texSprite);
 	particles.clear();
-	particles.insert(particles.begin(), 5000, p);
+	particles.insert(particles.begin(), numParticles, p);
 	for (size_t i = 0; i < (particles.size() - 1); ++i)
 		particles[i].pNext = &particles[i + 1];
 	pFree = &particles[0];
 	pBusy = nullptr;
+	numBusy = 0;
 }
 
 Particle * Particles::Remove(Particle * p, Particle * pPrev) {
@@ -26,6 +50,7 @@ Particle * Particles::Remove(Particle * p, Particle * pPrev) {
 	Particle *pNext = p->pNext;
 	p->pNext = pFree;
 	pFree = p;
+	--numBusy;
 	return pNext;
 }
 
@@ -46,91 +71,312 @@ void Particles::Update(float dT) {
 	}
 }
 
-void Particles::Render(sf::RenderWindow & window) {
+void Particles::Render(RenderBackend& gfx, const sf::FloatRect& view) {
+	numDrawn = numCulled = 0;
 	Particle *p = pBusy;
 	while (p) {
-		window.draw(p->spr, sf::RenderStates(sf::BlendAdd));
+		if (p->spr.getGlobalBounds().intersects(view)) {
+			gfx.Draw(p->spr, sf::RenderStates(sf::BlendAdd));
+			++numDrawn;
+		}
+		else
+			++numCulled;
 		p = p->pNext;
 	}
 }
 
-Particle * Emitter::GetNewParticle(Particles & cache) {
-	Particle *p = nullptr;
-	if (cache.pFree)
-	{
-		p = cache.pFree;
-		cache.pFree = p->pNext;
-		p->pNext = cache.pBusy; 
-		cache.pBusy = p;
+//what gets saved for each particle, the sprite itself can't be copied as raw bytes
+struct ParticleState {
+	int next;		//index of pNext, -1 for none
+	float life;
+	sf::Vector2f vel, pos, scale;
+	sf::Color colour;
+};
+
+void Particles::Save(Snapshot& snap) const {
+	auto indexOf = [this](const Particle *p) { return p ? (int)(p - particles.data()) : -1; };
+	snap.Write(particles.size());
+	snap.Write(indexOf(pBusy));
+	snap.Write(indexOf(pFree));
+	snap.Write(numBusy);
+	for (size_t i = 0; i < particles.size(); ++i) {
+		const Particle& p = particles[i];
+		ParticleState ps{ indexOf(p.pNext), p.life, p.vel, p.spr.getPosition(), p.spr.getScale(), p.spr.getColor() };
+		snap.Write(ps);
+	}
+}
+
+void Particles::Load(Snapshot& snap) {
+	auto fromIndex = [this](int idx) { return (idx >= 0) ? &particles[idx] : nullptr; };
+	auto valid = [this](int idx) { return idx >= -1 && idx < (int)particles.size(); };
+	size_t num = 0;
+	snap.Read(num);
+	int busyIdx, freeIdx;
+	snap.Read(busyIdx);
+	snap.Read(freeIdx);
+	snap.Read(numBusy);
+	if (num != particles.size() || !valid(busyIdx) || !valid(freeIdx) || numBusy < 0 || numBusy > (int)num) {
+		snap.Fail();
+		return;
+	}
+	pBusy = fromIndex(busyIdx);
+	pFree = fromIndex(freeIdx);
+	for (size_t i = 0; i < particles.size(); ++i) {
+		ParticleState ps;
+		snap.Read(ps);
+		if (!valid(ps.next)) {
+			snap.Fail();
+			return;
+		}
+		Particle& p = particles[i];
+		p.pNext = fromIndex(ps.next);
+		p.life = ps.life;
+		p.vel = ps.vel;
+		p.spr.setPosition(ps.pos);
+		p.spr.setScale(ps.scale);
+		p.spr.setColor(ps.colour);
 	}
-	return p;
+	//every particle is on one of the two lists, counting so a loop can't go round forever
+	size_t seen = 0;
+	int busy = 0;
+	for (const Particle *p = pBusy; p && seen <= num; p = p->pNext, ++seen)
+		++busy;
+	for (const Particle *p = pFree; p && seen <= num; p = p->pNext)
+		++seen;
+	if (seen != num || busy != numBusy)
+		snap.Fail();
 }
 
-void Emitter::Update(float dT, Particles & cache) 
+Particle * Particles::Acquire(int num, int& got) {
+	got = 0;
+	Particle *pFirst = pFree, *pLast = nullptr;
+	while (got < num && pFree) {
+		pLast = pFree;
+		pFree = pFree->pNext;
+		++got;
+	}
+	if (pLast) {
+		//splice the whole chain onto the front of the busy list
+		pLast->pNext = pBusy;
+		pBusy = pFirst;
+		numBusy += got;
+	}
+	return (got > 0) ? pFirst : nullptr;
+}
+
+void Emitter::Update(float dT, Particles & cache, Rng& rng) 
 {
 	if (alive) {
+		assert(rate > 0);
+		//bursts happen every rate seconds, how many of those fell inside this frame?
+		float since = lastEmit;
 		lastEmit += dT;
-		if (lastEmit > rate) {
-			int n = numAtOnce;
-			if (numAtOnce > numToEmit)
-				n = numToEmit;
-			while (n) {
-				Particle *p = GetNewParticle(cache);
-				if (p) {
-					p->life = life;
-					float alpha = (float)(rand() % 360);
-					float speed = (float)(initSpeed.x + rand() % (initSpeed.y - initSpeed.x));
-					p->vel = Vector2f(cosf(alpha), sinf(alpha)) * speed;
-					p->vel += initVel;
-					p->spr.setPosition(pos);
-					p->spr.setColor(colour);
-					p->spr.setScale(scale);
-					numToEmit--;
-					lastEmit = 0;
-				}
-				--n;   
-			}
+		int bursts = (int)(lastEmit / rate);
+		lastEmit -= bursts * rate;
+
+		int n = min(bursts * numAtOnce, numToEmit);
+		int got = 0;
+		Particle *p = cache.Acquire(n, got);
+		int speedRange = max(1, initSpeed.y - initSpeed.x);
+		for (int i = 0; i < got; ++i) {
+			//burst b happened (b+1)*rate-since seconds into the frame
+			int b = i / numAtOnce;
+			float age = dT - ((b + 1) * rate - since);
+			age = max(0.f, age);
+			float alpha = (float)rng.Range(360);
+			float speed = (float)(initSpeed.x + rng.Range(speedRange));
+			p->vel = Vector2f(cosf(alpha), sinf(alpha)) * speed;
+			p->vel += initVel;
+			p->life = life - age;
+			p->spr.setPosition(pos + p->vel * age);
+			p->spr.setColor(colour);
+			p->spr.setScale(scale);
+			p = p->pNext;
 		}
+		numToEmit -= n;
 		if (numToEmit <= 0) 
 			alive = false;
 	}
 }
 
-void ParticleSys::Init() {
-	//cache.Init();
-	//emitters.clear();
-	//emitters.insert(emitters.begin(), 50, Emitter());
+ParticleSys::ParticleSys() {
+	for (int i = 0; i < (int)EffectT::COUNT; ++i)
+		presets[i] = EFFECT_PRESETS[i];
+}
+
+bool ParticleSys::LoadPresets(const string& path) {
+	ifstream fs;
+	fs.open(path);
+	if (!fs.is_open() || !fs.good())
+		return false;
+	string name;
+	while (fs >> name) {
+		if (name[0] == '#') {
+			getline(fs, name);	//comment
+			continue;
+		}
+		EffectPreset p;
+		fs >> p.numToEmit >> p.numAtOnce >> p.rate >> p.r >> p.g >> p.b >> p.a >> p.scaleX >> p.scaleY
+			>> p.life >> p.speedMin >> p.speedMax >> p.sizeSpeedMin >> p.sizeSpeedMax >> p.useInitVel;
+		if (fs.fail()) {
+			DebugPrint("Bad particle effect: ", name);
+			return false;
+		}
+		int idx = 0;
+		while (idx < (int)EffectT::COUNT && name != EFFECT_PRESETS[idx].name)
+			++idx;
+		if (idx < (int)EffectT::COUNT) {
+			p.name = EFFECT_PRESETS[idx].name;
+			presets[idx] = p;
+		}
+		else
+			DebugPrint("Unknown particle effect: ", name);
+	}
+	return true;
+}
+
+void ParticleSys::SetupEffect(Emitter& em, const EffectReq& req) const {
+	const EffectPreset& p = presets[(int)req.type];
+	float sizeMult = (req.radius / GC::ROCK_RAD.y) * 2;
+	em.numToEmit = p.numToEmit;
+	em.numAtOnce = p.numAtOnce;
+	em.pos = req.pos;
+	em.rate = p.rate;
+	em.colour = Color((Uint8)p.r, (Uint8)p.g, (Uint8)p.b, (Uint8)p.a);
+	em.scale = Vector2f{ p.scaleX, p.scaleY };
+	em.life = p.life;
+	em.initSpeed.x = p.speedMin + (int)(p.sizeSpeedMin * sizeMult);
+	em.initSpeed.y = p.speedMax + (int)(p.sizeSpeedMax * sizeMult);
+	em.initVel = p.useInitVel ? req.initVel : Vector2f{ 0,0 };
+}
+
+Emitter *ParticleSys::SpawnEffect(const EffectReq& req) {
+	Emitter *em = GetNewEmitter();
+	if (em)
+		SetupEffect(*em, req);
+	return em;
+}
+
+void ParticleSys::Init(int numEmitters, OverflowT policy, int numParticles, bool loadTexture) {
+	cache.Init(numParticles, loadTexture);
+	overflow = policy;
+	emitters.clear();
+	active.clear();
+	activeHead = numActive = 0;
+	freeIdx.clear();
+	GrowPool(numEmitters);
+}
+
+void ParticleSys::GrowPool(int num) {
+	size_t first = emitters.size();
+	emitters.resize(first + num);
+	//unwrap the ring so the live ones are at the front before it gets bigger
+	rotate(active.begin(), active.begin() + activeHead, active.end());
+	activeHead = 0;
+	active.resize(emitters.size());
+	freeIdx.reserve(emitters.size());
+	//push in reverse so the lowest index is handed out first
+	for (size_t i = emitters.size(); i > first; --i)
+		freeIdx.push_back((int)i - 1);
 }
 
 void ParticleSys::Update(float dT) {
 	cache.Update(dT);
-	for (size_t i = 0; i < emitters.size(); ++i)
-		emitters[i].Update(dT, cache);
+	//update the live ones and squeeze out any that finish, keeping oldest first
+	int kept = 0;
+	for (int i = 0; i < numActive; ++i) {
+		int idx = ActiveAt(i);
+		Emitter& em = emitters[idx];
+		em.Update(dT, cache, rng);
+		if (em.alive)
+			ActiveAt(kept++) = idx;
+		else
+			freeIdx.push_back(idx);
+	}
+	numActive = kept;
+}
+
+void ParticleSys::Save(Snapshot& snap) const {
+	cache.Save(snap);
+	snap.WriteArray(emitters.data(), emitters.size());
+	snap.WriteArray(active.data(), active.size());
+	snap.Write(activeHead);
+	snap.Write(numActive);
+	snap.WriteArray(freeIdx.data(), freeIdx.size());
+	snap.Write(rng);
+}
+
+void ParticleSys::Load(Snapshot& snap) {
+	cache.Load(snap);
+	snap.ReadArray(emitters);
+	snap.ReadArray(active);
+	snap.Read(activeHead);
+	snap.Read(numActive);
+	snap.ReadArray(freeIdx);
+	snap.Read(rng);
+	//every index has to be an emitter
+	const int num = (int)emitters.size();
+	bool ok = active.size() == emitters.size() && numActive >= 0 && numActive <= num
+		&& activeHead >= 0 && activeHead < max(num, 1);
+	for (int i = 0; ok && i < numActive; ++i)
+		ok = ActiveAt(i) >= 0 && ActiveAt(i) < num;
+	for (size_t i = 0; ok && i < freeIdx.size(); ++i)
+		ok = freeIdx[i] >= 0 && freeIdx[i] < num;
+	if (!ok)
+		snap.Fail();
 }
 
-void ParticleSys::Render(sf::RenderWindow & window, float dT) {
-	cache.Render(window);
+void ParticleSys::Render(RenderBackend& gfx, float dT) {
+	const sf::Vector2u sz = gfx.GetSize();
+	cache.Render(gfx, sf::FloatRect(0, 0, (float)sz.x, (float)sz.y));
+}
+
+int ParticleSys::Acquire() {
+	if (freeIdx.empty()) {
+		switch (overflow) {
+		case OverflowT::RecycleOldest:
+			if (numActive == 0)
+				return -1;
+			freeIdx.push_back(active[activeHead]);
+			activeHead = (activeHead + 1) % (int)active.size();
+			--numActive;
+			break;
+		case OverflowT::Drop:
+			return -1;
+		case OverflowT::Grow:
+			GrowPool(max((int)emitters.size(), 8));
+			break;
+		default:
+			assert(false);
+		}
+	}
+	int idx = freeIdx.back();
+	freeIdx.pop_back();
+	ActiveAt(numActive++) = idx;
+	Emitter& em = emitters[idx];
+	em = Emitter();
+	em.alive = true;
+	return idx;
 }
 
 Emitter *ParticleSys::GetNewEmitter() {
-	Emitter *pOldest = nullptr, *pNew = nullptr;
-	size_t idx = 0;
+	int idx = Acquire();
+	return (idx < 0) ? nullptr : &emitters[idx];
+}
 
-	while (idx < emitters.size() && !pNew) {
-		if (!emitters[idx].alive)
-			pNew = &emitters[idx];
-		++idx;
+int ParticleSys::GetNewEmitters(int num, vector<Emitter*>& out) {
+	out.clear();
+	//recycling more than the whole pool would hand out the same emitter twice
+	if (overflow != OverflowT::Grow)
+		num = min(num, (int)emitters.size());
+	//grow once up front, growing half way through would move emitters we've already handed out
+	if (overflow == OverflowT::Grow && num > (int)freeIdx.size())
+		GrowPool(max(num - (int)freeIdx.size(), (int)emitters.size()));
+	for (int i = 0; i < num; ++i) {
+		int idx = Acquire();
+		if (idx < 0)
+			break;
+		out.push_back(&emitters[idx]);
 	}
-	if (!pNew)
-		return nullptr;
-	pNew->alive = true;
-	return pNew;
-}
-
-int ParticleSys::GetNumActiveEmitters() const {
-	int n = 0;
-	for (size_t i = 0; i < emitters.size(); ++i)
-		if (emitters[i].alive)
-			++n;
-	return n;
+	return (int)out.size();
 }
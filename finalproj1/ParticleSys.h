@@ -3,6 +3,15 @@
 
 #include "SFML/Graphics.hpp"
 #include "Utils.h"
+#include "EffectPresets.h"
+#include "RenderBackend.h"
+#include "Snapshot.h"
+
+namespace GC
+{
+	const int NUM_PARTICLES = 5000;		//size of the particle cache
+	const unsigned int PARTICLE_DOT = 32;	//width and height of the particle image
+}
 
 /*
 A tiny sprite flyign through the game world with a limited lifespan
@@ -24,18 +33,41 @@ struct Particles {
 	Particle *pFree = nullptr;//pFree linked list connects dead particles to be used again when needed
 	sf::Texture texSprite;		//a texture with the particle image on it for all the particle sprites
 
-	//setup thousands of particles ONCE
-	void Init();
+	int numBusy = 0;			//how many are in the pBusy list
+	int numDrawn = 0;			//particles the last Render drew
+	int numCulled = 0;			//particles the last Render skipped for being off screen
+
+	/*
+	setup thousands of particles ONCE
+	numParticles - how many to make
+	loadTexture - the benchmarks don't draw anything so don't need it
+	*/
+	void Init(int numParticles = GC::NUM_PARTICLES, bool loadTexture = true);
+	//the particle image, a soft white dot, there's no file for it
+	static void MakeDot(sf::Image& img);
 	//remove a particle from the busy list and put it in the free list to use again
 	Particle *Remove(Particle *p, Particle *pPrev);
+	/*
+	Move a batch of particles from the free list to the busy list in one go
+	num - how many we'd like
+	got - how many we actually got, could be fewer if the cache is running out
+	returns - the first one, the rest follow on through pNext
+	*/
+	Particle *Acquire(int num, int& got);
 	//run physics on all particles that are alive
 	void Update(float dT);
 	//are any particles alive?
 	bool IsBusy() const {
 		return pBusy!=nullptr;
 	}
-	//render every alive particle
-	void Render(sf::RenderWindow& window);
+	/*
+	render every alive particle that can be seen
+	view - the part of the world on screen
+	*/
+	void Render(RenderBackend& gfx, const sf::FloatRect& view);
+	//every particle and both lists, the cache must be the same size when it's loaded
+	void Save(Snapshot& snap) const;
+	void Load(Snapshot& snap);
 };
 
 /*
@@ -55,39 +87,99 @@ struct Emitter {
 	int numAtOnce = 1;		//how many to fire off at one
 	bool alive = false;		//is this emitter active
 
-	float lastEmit = 0;		//when did we emit last in seconds
+	float lastEmit = 0;		//seconds since the last burst
 
 	/*
-	See if there are any particles in the cache, does pFree point at anything?
-	If there is a free one then move it to the pBusy list
-	*/
-	Particle* GetNewParticle(Particles& cache);
-	/*
-	Give the emitter the chance to emit a particle
+	Emit every burst that was due during the last dT seconds, however long the frame was.
+	Each burst is aged by how long ago in the frame it should have happened, so it has
+	already moved a little and lost some life. If the cache runs out the particles
+	are skipped rather than delayed, so effects always last as long as they should
 	*/
-	void Update(float dT, Particles& cache);
+	void Update(float dT, Particles& cache, Rng& rng);
+};
+
+/*
+A request for an effect (explosion, splash, etc) somewhere in the game world
+These are collected while collisions are resolved and turned into
+emitters all in one go afterwards
+*/
+struct EffectReq {
+	EffectT type;			//which preset
+	sf::Vector2f pos;		//where it happens
+	sf::Vector2f initVel;	//effects can drift
+	float radius;			//size of whatever caused it, bigger things make bigger bangs
 };
 
 /*
 One object containing a cache of thousands of particles and
-a cache of Emitters to use in firing the particles off
+a pool of Emitters to use in firing the particles off.
+Live emitters are kept in a ring (oldest first) and dead ones on a
+stack, so getting a new one, recycling the oldest or counting the
+live ones is O(1)
 */
 struct ParticleSys {
+	//what to do when every emitter is busy and another one is wanted
+	enum class OverflowT {
+		RecycleOldest,	//cut the oldest effect short and reuse its emitter
+		Drop,			//no emitter, the effect doesn't happen
+		Grow			//add more emitters to the pool
+	};
 	Particles cache;				//thousands of particles
 	std::vector<Emitter> emitters;	//multiple emitters we can reuse for particle firing
+	std::vector<int> active;		//ring of live emitter indices, always as big as emitters
+	int activeHead = 0;				//where in active the oldest live one is
+	int numActive = 0;				//how many of active, from activeHead on, are live
+	std::vector<int> freeIdx;		//indices of dead emitters ready to reuse
+	OverflowT overflow = OverflowT::RecycleOldest;
+	EffectPreset presets[(int)EffectT::COUNT];	//starts as a copy of EFFECT_PRESETS, see LoadPresets
+	Rng rng;						//particle directions and speeds
 
 	/*
 	One time setup
+	numEmitters - how big the emitter pool starts
+	policy - what to do if the pool runs out
+	numParticles, loadTexture - passed on to the cache's Init
 	*/
-	void Init();
-	//let any alive emitters update
+	void Init(int numEmitters = 50, OverflowT policy = OverflowT::RecycleOldest, int numParticles = GC::NUM_PARTICLES, bool loadTexture = true);
+	ParticleSys();
+	//let any alive emitters update, dead ones go back in the pool
 	void Update(float dT);
 	//render all busy list particles
-	void Render(sf::RenderWindow& window, float dT);
-	//see if there is a dead emitter we can reuse
-	//could return a nullptr - meaning none available yet
+	void Render(RenderBackend& gfx, float dT);
+	//particles, emitters and the random numbers, not the presets as they don't change while playing
+	void Save(Snapshot& snap) const;
+	void Load(Snapshot& snap);
+	/*
+	Get an emitter from the pool, what happens if they are all busy depends on overflow
+	could return a nullptr - meaning none available yet
+	The pointer is only good until the next call, Grow can move the emitters
+	*/
 	Emitter* GetNewEmitter();
+	/*
+	Grab a batch of emitters in one go
+	num - how many we'd like
+	out - filled with the emitters we got, might be fewer than num
+	*/
+	int GetNewEmitters(int num, std::vector<Emitter*>& out);
 	//how many emitters are firing?
-	int GetNumActiveEmitters() const;
+	int GetNumActiveEmitters() const {
+		return numActive;
+	}
+	/*
+	Override presets by name from a text file, one per line, same order as the EffectPreset fields
+	Any not in the file keep their built in values
+	*/
+	bool LoadPresets(const std::string& path);
+	//set an emitter up from its preset, just a copy of the preset's numbers
+	void SetupEffect(Emitter& em, const EffectReq& req) const;
+	//get an emitter and set it up, nullptr if there isn't one
+	Emitter* SpawnEffect(const EffectReq& req);
+	//add num more dead emitters to the pool
+	void GrowPool(int num);
+	//the i'th live emitter's index, 0 is the oldest
+	int& ActiveAt(int i) {
+		return active[(activeHead + i) % active.size()];
+	}
+	//take an emitter out of the pool and make it live, -1 if there isn't one
+	int Acquire();
 };
-
@@ -0,0 +1,153 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <fstream>
+#include <algorithm>
+
+#include "PoissonDisk.h"
+
+using namespace sf;
+using namespace std;
+
+//0-1
+float Rand01()
+{
+	return (float)rand() / (float)RAND_MAX;
+}
+
+bool IsClear(const Disk& d, float spacing, const vector<Disk>& out, const vector<int>& cells,
+	int cols, int rows, float cellSz, int reach, const vector<Disk>& fixed)
+{
+	int cx = (int)(d.pos.x / cellSz), cy = (int)(d.pos.y / cellSz);
+	for (int y = max(0, cy - reach); y <= min(rows - 1, cy + reach); ++y)
+		for (int x = max(0, cx - reach); x <= min(cols - 1, cx + reach); ++x)
+		{
+			int idx = cells[y * cols + x];
+			if (idx >= 0)
+			{
+				const Disk& o = out[idx];
+				float minDist = (d.radius + o.radius) * spacing;
+				Vector2f diff = o.pos - d.pos;
+				if (diff.x * diff.x + diff.y * diff.y < minDist * minDist)
+					return false;
+			}
+		}
+	for (size_t i = 0; i < fixed.size(); ++i)
+	{
+		float minDist = (d.radius + fixed[i].radius) * spacing;
+		Vector2f diff = fixed[i].pos - d.pos;
+		if (diff.x * diff.x + diff.y * diff.y < minDist * minDist)
+			return false;
+	}
+	return true;
+}
+
+void PoissonDiskLayout(const Vector2u& area, const vector<float>& radii, float spacing,
+	const vector<Disk>& fixed, vector<Disk>& out, int tries)
+{
+	out.clear();
+	if (radii.empty() || area.x == 0 || area.y == 0)
+		return;
+	float minR = *min_element(radii.begin(), radii.end());
+	float maxR = *max_element(radii.begin(), radii.end());
+	assert(minR > 0 && spacing > 0);
+
+	//cells small enough that only one centre can ever be in each
+	const float cellSz = (2.f * minR * spacing) / sqrtf(2.f);
+	const int cols = (int)ceilf(area.x / cellSz), rows = (int)ceilf(area.y / cellSz);
+	//how many cells out we need to look to find anything within reach of the biggest disks
+	const int reach = (int)ceilf((2.f * maxR * spacing) / cellSz);
+	vector<int> cells(cols * rows, -1);
+	vector<int> active;
+	out.reserve(radii.size());
+
+	auto add = [&](const Disk& d) {
+		cells[(int)(d.pos.y / cellSz) * cols + (int)(d.pos.x / cellSz)] = (int)out.size();
+		active.push_back((int)out.size());
+		out.push_back(d);
+	};
+
+	//a random first disk, anywhere clear of the fixed ones
+	for (int i = 0; i < tries && out.empty(); ++i)
+	{
+		Disk d{ Vector2f(Rand01() * (area.x - 1), Rand01() * (area.y - 1)), radii[0] };
+		if (IsClear(d, spacing, out, cells, cols, rows, cellSz, reach, fixed))
+			add(d);
+	}
+
+	while (!active.empty() && out.size() < radii.size())
+	{
+		int a = rand() % active.size();
+		const Disk from = out[active[a]];
+		float r = radii[out.size()];
+		bool placed = false;
+		for (int i = 0; i < tries && !placed; ++i)
+		{
+			//somewhere in the ring between touching distance and twice that
+			float minDist = (from.radius + r) * spacing;
+			float dist = minDist * (1.f + Rand01());
+			float angle = Rand01() * 6.2831853f;
+			Disk d{ from.pos + Vector2f(cosf(angle), sinf(angle)) * dist, r };
+			if (d.pos.x >= 0 && d.pos.y >= 0 && d.pos.x < area.x && d.pos.y < area.y &&
+				IsClear(d, spacing, out, cells, cols, rows, cellSz, reach, fixed))
+			{
+				add(d);
+				placed = true;
+			}
+		}
+		if (!placed)
+		{
+			//nothing fits around this one, stop growing from it
+			active[a] = active.back();
+			active.pop_back();
+		}
+	}
+}
+
+bool SaveLayouts(const string& path, const vector<DiskLayout>& layouts)
+{
+	ofstream fs;
+	fs.open(path);
+	if (!fs.is_open() || !fs.good())
+	{
+		assert(false);
+		return false;
+	}
+	fs << layouts.size() << '\n';
+	for (size_t i = 0; i < layouts.size(); ++i)
+	{
+		const DiskLayout& l = layouts[i];
+		fs << l.area.x << ' ' << l.area.y << ' ' << l.disks.size() << '\n';
+		for (size_t d = 0; d < l.disks.size(); ++d)
+			fs << l.disks[d].pos.x << ' ' << l.disks[d].pos.y << ' ' << l.disks[d].radius << '\n';
+	}
+	assert(!fs.fail());
+	return !fs.fail();
+}
+
+bool LoadLayouts(const string& path, vector<DiskLayout>& layouts)
+{
+	layouts.clear();
+	ifstream fs;
+	fs.open(path);
+	if (!fs.is_open() || !fs.good())
+		return false;
+	size_t num = 0;
+	fs >> num;
+	layouts.resize(num);
+	for (size_t i = 0; i < num && fs.good(); ++i)
+	{
+		DiskLayout& l = layouts[i];
+		size_t numDisks = 0;
+		fs >> l.area.x >> l.area.y >> numDisks;
+		l.disks.resize(numDisks);
+		for (size_t d = 0; d < numDisks && fs.good(); ++d)
+			fs >> l.disks[d].pos.x >> l.disks[d].pos.y >> l.disks[d].radius;
+	}
+	if (fs.fail())
+	{
+		layouts.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <string>
+
+#include "SFML/Graphics.hpp"
+
+/*
+A circle placed by the layout generator
+*/
+struct Disk {
+	sf::Vector2f pos;
+	float radius;
+};
+
+/*
+A set of disks for one screen, pre-generated layouts are saved with
+the size of the area they were made for
+*/
+struct DiskLayout {
+	sf::Vector2u area;
+	std::vector<Disk> disks;
+};
+
+/*
+Bridson style Poisson disk sampling, but every disk can be a different size.
+New disks are grown out from ones already placed, a background grid means each
+test only looks at a few nearby disks, so it's O(n) rather than testing everything
+area - width and height to fill
+radii - how big each disk is, it places up to radii.size() disks in this order
+spacing - centres are kept at least (r1+r2)*spacing apart
+fixed - things already on the screen to keep away from (the player, etc)
+out - the disks that were placed, may be fewer than radii.size() if it fills up
+tries - how many times to try growing from a disk before giving up on it
+*/
+void PoissonDiskLayout(const sf::Vector2u& area, const std::vector<float>& radii, float spacing,
+	const std::vector<Disk>& fixed, std::vector<Disk>& out, int tries = 30);
+
+//text file of layouts so they can be made offline and just loaded in by the game
+bool SaveLayouts(const std::string& path, const std::vector<DiskLayout>& layouts);
+bool LoadLayouts(const std::string& path, std::vector<DiskLayout>& layouts);
@@ -0,0 +1,247 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+#include "Projectiles.h"
+
+using namespace sf;
+using namespace std;
+
+void Projectiles::Init(const Texture *tex, int maxNum)
+{
+	pTex = tex;
+	x.resize(maxNum);
+	y.resize(maxNum);
+	x0.resize(maxNum);
+	y0.resize(maxNum);
+	vx.resize(maxNum);
+	vy.resize(maxNum);
+	t0.resize(maxNum);
+	faction.resize(maxNum);
+	owner.resize(maxNum);
+	id.resize(maxNum);
+	expiry.resize(maxNum);
+	slotOf.resize(maxNum);
+	freeIds.reserve(maxNum);
+	dead.reserve(maxNum);
+	due.reserve(maxNum);
+	wheel.Reserve(maxNum);
+	//grow the vertices once now, resizing smaller later keeps the memory
+	quads.setPrimitiveType(Quads);
+	quads.resize(maxNum * 4);
+	Clear();
+	numDropped = 0;
+}
+
+void Projectiles::Clear()
+{
+	num = 0;
+	now = 0;
+	dead.clear();
+	wheel.Clear();
+	//handed out lowest first
+	freeIds.clear();
+	for (int i = (int)id.size() - 1; i >= 0; --i)
+		freeIds.push_back(i);
+}
+
+float Projectiles::TimeToExit(const Vector2f& pos, const Vector2f& vel) const
+{
+	//the first edge crossed on either axis, a bullet already outside goes straight away
+	float t = GC::PROJECTILE_LIFE;
+	if (vel.x > 0)
+		t = min(t, (area.left + area.width - pos.x) / vel.x);
+	else if (vel.x < 0)
+		t = min(t, (area.left - pos.x) / vel.x);
+	else if (pos.x < area.left || pos.x > area.left + area.width)
+		t = 0;
+	if (vel.y > 0)
+		t = min(t, (area.top + area.height - pos.y) / vel.y);
+	else if (vel.y < 0)
+		t = min(t, (area.top - pos.y) / vel.y);
+	else if (pos.y < area.top || pos.y > area.top + area.height)
+		t = 0;
+	return max(t, 0.f);
+}
+
+bool Projectiles::Fire(const Vector2f& pos, const Vector2f& vel, Layer layer, int ownerIdx)
+{
+	assert(layer == Layer::PlayerBullet || layer == Layer::EnemyBullet);
+	if (num >= (int)x.size())
+	{
+		++numDropped;
+		return false;
+	}
+	x[num] = x0[num] = pos.x;
+	y[num] = y0[num] = pos.y;
+	vx[num] = vel.x;
+	vy[num] = vel.y;
+	t0[num] = now;
+	faction[num] = (unsigned char)layer;
+	owner[num] = ownerIdx;
+	id[num] = freeIds.back();
+	freeIds.pop_back();
+	slotOf[id[num]] = num;
+	expiry[num] = wheel.Schedule(now + TimeToExit(pos, vel), GameEvent{ GameEvent::EvT::ProjectileExpire, (unsigned int)id[num] });
+	++num;
+	return true;
+}
+
+void Projectiles::Kill(int i)
+{
+	if (!IsLive(i))
+		return;
+	wheel.Cancel(expiry[i]);
+	dead.push_back(i);
+}
+
+void Projectiles::Remove(int i)
+{
+	--num;
+	freeIds.push_back(id[i]);
+	if (i == num)
+		return;
+	x0[i] = x0[num];
+	y0[i] = y0[num];
+	vx[i] = vx[num];
+	vy[i] = vy[num];
+	t0[i] = t0[num];
+	faction[i] = faction[num];
+	owner[i] = owner[num];
+	id[i] = id[num];
+	expiry[i] = expiry[num];
+	slotOf[id[i]] = i;
+}
+
+void Projectiles::Evaluate()
+{
+	//straight through the arrays, nothing in here stops the compiler using SIMD
+	float *px = x.data(), *py = y.data();
+	const float *px0 = x0.data(), *py0 = y0.data(), *pvx = vx.data(), *pvy = vy.data(), *pt0 = t0.data();
+	for (int i = 0; i < num; ++i)
+	{
+		const float t = now - pt0[i];
+		px[i] = px0[i] + pvx[i] * t;
+		py[i] = py0[i] + pvy[i] * t;
+	}
+}
+
+void Projectiles::Update(float now_)
+{
+	now = now_;
+	//only the bullets whose time is up come back, the rest aren't looked at
+	due.clear();
+	wheel.Advance(now, due);
+	for (const GameEvent& ev : due)
+	{
+		assert(ev.type == GameEvent::EvT::ProjectileExpire);
+		int i = slotOf[ev.obj];
+		expiry[i] = TimerId{};
+		dead.push_back(i);
+	}
+	//highest first, so whatever moves into a gap has already been checked
+	sort(dead.begin(), dead.end(), greater<int>());
+	for (int i : dead)
+		Remove(i);
+	dead.clear();
+	Evaluate();
+}
+
+void Projectiles::Render(RenderBackend& gfx)
+{
+	if (num == 0)
+		return;
+	quads.resize(num * 4);
+	const float h = GC::PROJECTILE_SIZE / 2.f;
+	const float u0 = (float)texRect.left, v0 = (float)texRect.top;
+	const float u1 = u0 + texRect.width, v1 = v0 + texRect.height;
+	const Color playerCol(128, 128, 255, 255), enemyCol(255, 128, 128, 255);
+	for (int i = 0; i < num; ++i)
+	{
+		const Color& col = (faction[i] == (unsigned char)Layer::PlayerBullet) ? playerCol : enemyCol;
+		Vertex *pV = &quads[i * 4];
+		pV[0] = Vertex(Vector2f(x[i] - h, y[i] - h), col, Vector2f(u0, v0));
+		pV[1] = Vertex(Vector2f(x[i] + h, y[i] - h), col, Vector2f(u1, v0));
+		pV[2] = Vertex(Vector2f(x[i] + h, y[i] + h), col, Vector2f(u1, v1));
+		pV[3] = Vertex(Vector2f(x[i] - h, y[i] + h), col, Vector2f(u0, v1));
+	}
+	gfx.Draw(quads, RenderStates(pTex));
+}
+
+void Projectiles::Save(Snapshot& snap) const
+{
+	snap.WriteArray(x0.data(), num);
+	snap.WriteArray(y0.data(), num);
+	snap.WriteArray(vx.data(), num);
+	snap.WriteArray(vy.data(), num);
+	snap.WriteArray(t0.data(), num);
+	snap.WriteArray(faction.data(), num);
+	snap.WriteArray(owner.data(), num);
+	snap.WriteArray(id.data(), num);
+	snap.WriteArray(expiry.data(), num);
+	snap.WriteArray(dead.data(), dead.size());
+	snap.Write(area);
+	snap.Write(now);
+	wheel.Save(snap);
+}
+
+size_t Projectiles::SaveBytes(size_t numShots) const
+{
+	//everything Save writes per bullet, plus its place in dead and its node on the wheel
+	const size_t perShot = sizeof(x0[0]) + sizeof(y0[0]) + sizeof(vx[0]) + sizeof(vy[0]) + sizeof(t0[0])
+		+ sizeof(faction[0]) + sizeof(owner[0]) + sizeof(id[0]) + sizeof(expiry[0]) + sizeof(int) + sizeof(TimingWheel::Node);
+	return numShots * perShot;
+}
+
+void Projectiles::Load(Snapshot& snap)
+{
+	num = (int)snap.ReadArray(x0.data(), x0.size());
+	//the rest must have one each too
+	size_t sizes[]{ snap.ReadArray(y0.data(), y0.size()), snap.ReadArray(vx.data(), vx.size()),
+		snap.ReadArray(vy.data(), vy.size()), snap.ReadArray(t0.data(), t0.size()),
+		snap.ReadArray(faction.data(), faction.size()), snap.ReadArray(owner.data(), owner.size()),
+		snap.ReadArray(id.data(), id.size()), snap.ReadArray(expiry.data(), expiry.size()) };
+	for (size_t sz : sizes)
+		if (sz != (size_t)num)
+			snap.Fail();
+	snap.ReadArray(dead);
+	snap.Read(area);
+	snap.Read(now);
+	wheel.Load(snap);
+	if (snap.failed)
+	{
+		num = 0;
+		return;
+	}
+	//ids not in use are whatever the live ones don't have, each id can only be used once
+	fill(slotOf.begin(), slotOf.end(), -1);
+	for (int i = 0; i < num; ++i)
+	{
+		if (id[i] < 0 || id[i] >= (int)slotOf.size() || slotOf[id[i]] >= 0 || expiry[i].idx >= (int)wheel.nodes.size()
+			|| (faction[i] != (unsigned char)Layer::PlayerBullet && faction[i] != (unsigned char)Layer::EnemyBullet))
+		{
+			snap.Fail();
+			num = 0;
+			return;
+		}
+		slotOf[id[i]] = i;
+	}
+	//and anything the wheel hands back has to be a live bullet
+	bool ok = true;
+	for (int i : dead)
+		ok = ok && i >= 0 && i < num;
+	for (const TimingWheel::Node& node : wheel.nodes)
+		ok = ok && (node.slot < 0 || (node.ev.type == GameEvent::EvT::ProjectileExpire && node.ev.obj < slotOf.size() && slotOf[node.ev.obj] >= 0));
+	if (!ok)
+	{
+		snap.Fail();
+		num = 0;
+		return;
+	}
+	freeIds.clear();
+	for (int i = (int)slotOf.size() - 1; i >= 0; --i)
+		if (slotOf[i] < 0)
+			freeIds.push_back(i);
+	Evaluate();
+}
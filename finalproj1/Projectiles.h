@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+#include "Collision.h"
+#include "RenderBackend.h"
+#include "Snapshot.h"
+#include "Scheduler.h"
+
+namespace GC
+{
+	const int MAX_PROJECTILES = 65536;		//every bullet in flight, the player's and the enemies'
+	const float PROJECTILE_RADIUS = 5.f;	//collision radius
+	const float PROJECTILE_SIZE = 16.f;		//width and height when drawn
+	const float PROJECTILE_LIFE = 10.f;		//seconds before a bullet that never left the screen is taken out anyway
+}
+
+/*
+Every bullet in the game, kept as separate arrays rather than objects so the
+update is one tight loop over a few floats and they can all be drawn with
+a single call. Bullets fly in straight lines at a constant speed, so each
+one is just where and when it was fired and its velocity, the position at
+any time is worked out from those. When it will leave the play area (or run
+out of time) is also worked out when it's fired and put on a timing wheel,
+so nothing is checked per bullet per frame to find the finished ones.
+Live bullets are packed at the front, when one dies the last one is moved
+into its place. Nothing is allocated after Init
+*/
+struct Projectiles {
+	std::vector<float> x, y;		//centres at the last Update, for collisions and drawing
+	std::vector<float> x0, y0;		//where it was fired from
+	std::vector<float> vx, vy;		//units per second
+	std::vector<float> t0;			//when it was fired
+	std::vector<unsigned char> faction;	//collision layer, Layer::PlayerBullet or Layer::EnemyBullet
+	std::vector<int> owner;			//index into the objects array of whoever fired it
+	std::vector<int> id;			//stays the same when the bullet is moved, its expiry event refers to this
+	std::vector<TimerId> expiry;	//when it goes, no timer once it's been killed
+	std::vector<int> slotOf;		//from an id to where that bullet is now
+	std::vector<int> freeIds;		//ids not in use
+	std::vector<int> dead;			//killed or expired, taken out at the end of Update
+	std::vector<GameEvent> due;		//scratch, expiry events handed back by the wheel
+	TimingWheel wheel;				//every live bullet's expiry
+	sf::FloatRect area;				//anything outside this is finished, see SetArea
+	float now = 0;					//game time of the last Update
+	int num = 0;					//how many are live
+	int numDropped = 0;				//shots fired while every slot was full
+	const sf::Texture *pTex = nullptr;	//bullet image, nullptr just draws coloured squares
+	sf::IntRect texRect{ 0, 0, 32, 32 };	//part of the texture to use
+	sf::VertexArray quads;			//rebuilt by Render, four corners per bullet
+
+	/*
+	Make room for the most there can ever be
+	tex - bullet image, can be nullptr
+	maxNum - how many can be in flight at once
+	*/
+	void Init(const sf::Texture *tex, int maxNum = GC::MAX_PROJECTILES);
+	//none in flight and back to time zero
+	void Clear();
+	//where bullets fired from now on are finished, ones already in flight keep the area they were fired in
+	void SetArea(const sf::FloatRect& area_) {
+		area = area_;
+	}
+	/*
+	The bullet starts from the time of the last Update, so it moves on its first one
+	pos - where from
+	vel - units per second
+	layer - whose side it's on
+	ownerIdx - index of whoever fired it
+	returns - false if there's no room
+	*/
+	bool Fire(const sf::Vector2f& pos, const sf::Vector2f& vel, Layer layer, int ownerIdx);
+	/*
+	Take out the ones that were killed or whose time is up, then work out where the rest are
+	now_ - game seconds
+	*/
+	void Update(float now_);
+	//finish one off, it stays in place until the next Update so indices don't change mid frame
+	void Kill(int i);
+	bool IsLive(int i) const {
+		return expiry[i].idx >= 0;
+	}
+	sf::Vector2f GetPos(int i) const {
+		return sf::Vector2f(x[i], y[i]);
+	}
+	//all of them in one draw call
+	void Render(RenderBackend& gfx);
+	//only the live ones are written, Init must have been called with the same size first
+	void Save(Snapshot& snap) const;
+	void Load(Snapshot& snap);
+	//what Save writes for numShots in flight on top of what it writes with none, for reserving snapshots
+	size_t SaveBytes(size_t numShots) const;
+
+	//seconds from pos until it leaves the area going at vel, or PROJECTILE_LIFE if that's sooner
+	float TimeToExit(const sf::Vector2f& pos, const sf::Vector2f& vel) const;
+	//x and y from the start, velocity and time
+	void Evaluate();
+	//the last live one goes into slot i
+	void Remove(int i);
+};
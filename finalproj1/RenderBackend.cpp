@@ -0,0 +1,52 @@
+#include "RenderBackend.h"
+
+using namespace sf;
+using namespace std;
+
+//rough pixel count for a submission, what's on screen of its bounding box
+long long CoveredPixels(const FloatRect& bounds, const Vector2u& screenSz)
+{
+	FloatRect visible;
+	if (!bounds.intersects(FloatRect(0, 0, (float)screenSz.x, (float)screenSz.y), visible))
+		return 0;
+	return (long long)(visible.width * visible.height);
+}
+
+void SFMLBackend::Clear(const Color& col)
+{
+	target.clear(col);
+}
+
+void SFMLBackend::Draw(const Sprite& spr, const RenderStates& states)
+{
+	target.draw(spr, states);
+	stats.drawCalls++;
+	stats.pixels += CoveredPixels(states.transform.transformRect(spr.getGlobalBounds()), target.getSize());
+}
+
+void SFMLBackend::Draw(const Text& txt)
+{
+	target.draw(txt);
+	stats.drawCalls++;
+	stats.pixels += CoveredPixels(txt.getGlobalBounds(), target.getSize());
+}
+
+void AlignText(Text& txt, const Vector2f& align)
+{
+	FloatRect fr = txt.getLocalBounds();
+	txt.setOrigin(fr.left + fr.width * align.x, fr.top + fr.height * align.y);
+}
+
+void SFMLBackend::DrawAligned(const Text& txt, const Vector2f& align)
+{
+	Text aligned(txt);
+	AlignText(aligned, align);
+	Draw(aligned);
+}
+
+void SFMLBackend::Draw(const VertexArray& verts, const RenderStates& states)
+{
+	target.draw(verts, states);
+	stats.drawCalls++;
+	stats.pixels += CoveredPixels(states.transform.transformRect(verts.getBounds()), target.getSize());
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "SFML/Graphics.hpp"
+
+/*
+Counters for what a frame asked to be drawn
+*/
+struct RenderStats {
+	int drawCalls = 0;		//submissions (one sprite, one text, one vertex array)
+	long long pixels = 0;	//pixels touched, the SFML backend can only estimate from bounds
+
+	void Reset() {
+		drawCalls = 0;
+		pixels = 0;
+	}
+};
+
+/*
+Everything the game draws goes through one of these, so the same render
+code can draw to the window or to memory (see SoftwareBackend)
+*/
+struct RenderBackend {
+	RenderStats stats;		//since the last stats.Reset()
+
+	virtual ~RenderBackend() {}
+	//width and height of what we're drawing on
+	virtual sf::Vector2u GetSize() const = 0;
+	virtual void Clear(const sf::Color& col = sf::Color::Black) = 0;
+	virtual void Draw(const sf::Sprite& spr, const sf::RenderStates& states = sf::RenderStates::Default) = 0;
+	virtual void Draw(const sf::Text& txt) = 0;
+	/*
+	Draw text laid out by its bounds, which only whoever does the drawing
+	measures. Measuring adds glyphs to the font, so game code never does it
+	itself, see RenderFrame
+	align - which point of the bounds goes at the text's position, (0.5,0.5) centres it, (0.5,1) is the bottom middle
+	*/
+	virtual void DrawAligned(const sf::Text& txt, const sf::Vector2f& align) = 0;
+	virtual void Draw(const sf::VertexArray& verts, const sf::RenderStates& states = sf::RenderStates::Default) = 0;
+	//the GPU target underneath, if there is one, so things can be drawn off screen and kept (see LayerCompositor)
+	virtual sf::RenderTarget* GetTarget() {
+		return nullptr;
+	}
+};
+
+/*
+Draws with SFML onto a window or render texture
+*/
+struct SFMLBackend : public RenderBackend {
+	sf::RenderTarget& target;
+
+	SFMLBackend(sf::RenderTarget& _target) : target(_target) {}
+	sf::Vector2u GetSize() const override {
+		return target.getSize();
+	}
+	void Clear(const sf::Color& col = sf::Color::Black) override;
+	void Draw(const sf::Sprite& spr, const sf::RenderStates& states = sf::RenderStates::Default) override;
+	void Draw(const sf::Text& txt) override;
+	void DrawAligned(const sf::Text& txt, const sf::Vector2f& align) override;
+	void Draw(const sf::VertexArray& verts, const sf::RenderStates& states = sf::RenderStates::Default) override;
+	sf::RenderTarget* GetTarget() override {
+		return &target;
+	}
+};
+
+/*
+Move a text's origin to a point on its bounds, this measures it with its font
+txt - changed in place
+align - see RenderBackend::DrawAligned
+*/
+void AlignText(sf::Text& txt, const sf::Vector2f& align);
@@ -0,0 +1,174 @@
+#include <assert.h>
+
+#include "RenderFrame.h"
+
+using namespace sf;
+using namespace std;
+
+//the next spare element, only grows the first time a frame has this many
+template<typename T>
+T& NextSlot(vector<T>& vec, int& num)
+{
+	if (num == (int)vec.size())
+		vec.emplace_back();
+	return vec[num++];
+}
+
+void RenderFrame::Begin()
+{
+	cmds.clear();
+	numSprites = numTexts = numVerts = 0;
+	stats.Reset();
+}
+
+void RenderFrame::Reserve(size_t maxSprites, size_t maxVerts)
+{
+	cmds.reserve(maxSprites + GC::FRAME_SPARE_CMDS);
+	if (sprites.size() < maxSprites)
+		sprites.resize(maxSprites);
+	if (texts.size() < (size_t)GC::FRAME_TEXTS)
+		texts.resize(GC::FRAME_TEXTS);
+	//copying a vertex array into this one keeps its memory, clearing it does too
+	if (verts.empty())
+		verts.resize(1);
+	if (verts[0].getVertexCount() < maxVerts)
+	{
+		verts[0].resize(maxVerts);
+		verts[0].clear();
+	}
+}
+
+void RenderFrame::Clear(const Color& col)
+{
+	cmds.push_back(Cmd{ CmdT::Clear, 0, col, RenderStates::Default });
+}
+
+void RenderFrame::Draw(const Sprite& spr, const RenderStates& states)
+{
+	cmds.push_back(Cmd{ CmdT::Sprite, numSprites, Color::Black, states });
+	NextSlot(sprites, numSprites) = spr;
+	stats.drawCalls++;
+}
+
+void RenderFrame::Draw(const Text& txt)
+{
+	cmds.push_back(Cmd{ CmdT::Text, numTexts, Color::Black, RenderStates::Default });
+	TextItem& item = NextSlot(texts, numTexts);
+	item.str = txt.getString();
+	item.pFont = txt.getFont();
+	item.charSize = txt.getCharacterSize();
+	item.style = txt.getStyle();
+	item.fill = txt.getFillColor();
+	item.xf = txt;
+	item.aligned = false;
+	stats.drawCalls++;
+}
+
+void RenderFrame::DrawAligned(const Text& txt, const Vector2f& align)
+{
+	//measuring it here would be on the simulation thread, Play does it
+	Draw(txt);
+	texts[numTexts - 1].aligned = true;
+	texts[numTexts - 1].align = align;
+}
+
+void RenderFrame::Draw(const VertexArray& va, const RenderStates& states)
+{
+	cmds.push_back(Cmd{ CmdT::Verts, numVerts, Color::Black, states });
+	//copying over an old array keeps its memory if it's big enough
+	NextSlot(verts, numVerts) = va;
+	stats.drawCalls++;
+}
+
+void RenderFrame::Play(RenderBackend& gfx)
+{
+	for (size_t i = 0; i < cmds.size(); ++i)
+	{
+		const Cmd& cmd = cmds[i];
+		switch (cmd.type)
+		{
+		case CmdT::Clear:
+			gfx.Clear(cmd.col);
+			break;
+		case CmdT::Sprite:
+			gfx.Draw(sprites[cmd.idx], cmd.states);
+			break;
+		case CmdT::Text:
+		{
+			const TextItem& item = texts[cmd.idx];
+			assert(item.pFont);
+			playTxt.setString(item.str);
+			playTxt.setFont(*item.pFont);
+			playTxt.setCharacterSize(item.charSize);
+			playTxt.setStyle(item.style);
+			playTxt.setFillColor(item.fill);
+			playTxt.setPosition(item.xf.getPosition());
+			playTxt.setScale(item.xf.getScale());
+			playTxt.setRotation(item.xf.getRotation());
+			if (item.aligned)
+				AlignText(playTxt, item.align);
+			else
+				playTxt.setOrigin(item.xf.getOrigin());
+			gfx.Draw(playTxt);
+			break;
+		}
+		case CmdT::Verts:
+			gfx.Draw(verts[cmd.idx], cmd.states);
+			break;
+		default:
+			assert(false);
+		}
+	}
+}
+
+void RenderFrames::Init(size_t maxSprites, size_t maxVerts)
+{
+	for (RenderFrame& frame : frames)
+		frame.Reserve(maxSprites, maxVerts);
+	writing = 0;
+	ready = 1;
+	reading = 2;
+	fresh = false;
+	quit = false;
+}
+
+RenderFrame& RenderFrames::BeginWrite(const Vector2u& size)
+{
+	//only the simulation thread touches writing, no lock needed
+	RenderFrame& frame = frames[writing];
+	frame.Begin();
+	frame.size = size;
+	return frame;
+}
+
+void RenderFrames::Publish()
+{
+	{
+		lock_guard<mutex> lock(mtx);
+		swap(writing, ready);
+		fresh = true;
+		++numPublished;
+	}
+	cvReady.notify_one();
+}
+
+RenderFrame* RenderFrames::Acquire()
+{
+	unique_lock<mutex> lock(mtx);
+	cvReady.wait(lock, [this] { return fresh || quit; });
+	if (quit)
+		return nullptr;
+	swap(reading, ready);
+	fresh = false;
+	++numDrawn;
+	return &frames[reading];
+}
+
+void RenderFrames::Stop()
+{
+	{
+		lock_guard<mutex> lock(mtx);
+		quit = true;
+	}
+	cvReady.notify_all();
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "SFML/Graphics.hpp"
+#include "RenderBackend.h"
+
+namespace GC
+{
+	const int FRAME_TEXTS = 16;			//pieces of text a recorded frame has room for up front
+	const int FRAME_SPARE_CMDS = 64;	//room for clears, text and vertex arrays on top of the sprites
+}
+
+/*
+A RenderBackend that doesn't draw anything, it writes down what it's asked
+to draw so another thread can draw it later with Play. Sprites, text and
+vertex arrays are copied in, so once the game has rendered into one of these
+it doesn't point back at anything the next update will change, only at
+textures, which never do, and fonts. A font does change, measuring or drawing
+text adds glyphs to it, so only the render thread may do either. Text that
+needs its bounds for layout is recorded with DrawAligned and measured by Play.
+Everything is kept and written over the next time, so once the game has
+settled down recording doesn't allocate
+*/
+struct RenderFrame : public RenderBackend {
+	enum class CmdT { Clear, Sprite, Text, Verts };
+	struct Cmd {
+		CmdT type;
+		int idx;					//into sprites, texts or verts
+		sf::Color col;				//what to clear to
+		sf::RenderStates states;
+	};
+	//enough to put a piece of text back together, a whole sf::Text copy would bring its vertices too
+	struct TextItem {
+		sf::String str;
+		const sf::Font *pFont = nullptr;
+		unsigned int charSize = 0;
+		sf::Uint32 style = 0;
+		sf::Color fill;
+		sf::Transformable xf;
+		bool aligned = false;		//set the origin from the bounds when it's played, see DrawAligned
+		sf::Vector2f align;
+	};
+
+	sf::Vector2u size;					//of whatever it will be played onto
+	std::vector<Cmd> cmds;				//in the order they were drawn
+	std::vector<sf::Sprite> sprites;
+	std::vector<TextItem> texts;
+	std::vector<sf::VertexArray> verts;
+	int numSprites = 0, numTexts = 0, numVerts = 0;	//in use this frame, the rest are spare
+	sf::Text playTxt;					//rebuilt for each piece of text by Play
+
+	RenderFrame(const sf::Vector2u& _size = sf::Vector2u(0, 0)) : size(_size) {}
+	//forget the last frame, keeping the memory
+	void Begin();
+	/*
+	Make room up front so recording never allocates, however busy the game gets
+	maxSprites - most sprites in a frame
+	maxVerts - most vertices in the first vertex array, in game that's always the bullets
+	*/
+	void Reserve(size_t maxSprites, size_t maxVerts);
+	sf::Vector2u GetSize() const override {
+		return size;
+	}
+	void Clear(const sf::Color& col = sf::Color::Black) override;
+	void Draw(const sf::Sprite& spr, const sf::RenderStates& states = sf::RenderStates::Default) override;
+	void Draw(const sf::Text& txt) override;
+	void DrawAligned(const sf::Text& txt, const sf::Vector2f& align) override;
+	void Draw(const sf::VertexArray& verts, const sf::RenderStates& states = sf::RenderStates::Default) override;
+	//do every draw that was recorded, in order
+	void Play(RenderBackend& gfx);
+};
+
+/*
+Three RenderFrames passed between the simulation and render threads. The
+simulation always has one to write into and never waits, the render thread
+always draws the newest one finished and only waits if it has already drawn
+that. A frame the render thread was too slow for is just written over
+*/
+struct RenderFrames {
+	RenderFrame frames[3];
+	int writing = 0;		//the simulation's
+	int ready = 1;			//newest finished one
+	int reading = 2;		//the render thread's
+	bool fresh = false;		//ready hasn't been picked up yet
+	bool quit = false;
+	std::mutex mtx;
+	std::condition_variable cvReady;
+	int numPublished = 0;	//frames finished by the simulation
+	int numDrawn = 0;		//frames picked up by the render thread, the rest were skipped
+
+	/*
+	start again, e.g. before starting a new render thread
+	maxSprites, maxVerts - see RenderFrame::Reserve
+	*/
+	void Init(size_t maxSprites, size_t maxVerts);
+	/*
+	Simulation thread, an empty frame to record into
+	size - of the window it will be drawn in
+	*/
+	RenderFrame& BeginWrite(const sf::Vector2u& size);
+	//simulation thread, the frame from BeginWrite is finished
+	void Publish();
+	//render thread, waits for a frame newer than the last one, nullptr once Stop is called
+	RenderFrame* Acquire();
+	//let the render thread finish
+	void Stop();
+};
@@ -0,0 +1,241 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+#include "Scheduler.h"
+
+using namespace std;
+
+void TimingWheel::Clear()
+{
+	fill(begin(heads), end(heads), -1);
+	fill(begin(tails), end(tails), -1);
+	//keep the nodes and bump their generations, so no handle from before can cancel anything new
+	freeHead = -1;
+	for (int n = (int)nodes.size() - 1; n >= 0; --n)
+		FreeNode(n);
+	curTick = 0;
+	numPending = 0;
+}
+
+TimerId TimingWheel::Schedule(float time, const GameEvent& ev)
+{
+	//round up, an event is never handed back before its time
+	unsigned int due = (unsigned int)ceilf(max(time, 0.f) / GC::SCHED_TICK);
+	if (due <= curTick)
+		due = curTick + 1;
+	//past the top of the wheel, it'll just have to go off at the limit
+	const unsigned int RANGE = 1u << (GC::WHEEL_BITS * GC::WHEEL_LEVELS);
+	if (due - curTick >= RANGE)
+		due = curTick + RANGE - 1;
+
+	int n = freeHead;
+	if (n >= 0)
+		freeHead = nodes[n].next;
+	else
+	{
+		n = (int)nodes.size();
+		nodes.push_back(Node{});
+	}
+	nodes[n].ev = ev;
+	nodes[n].due = due;
+	Place(n);
+	++numPending;
+	return TimerId{ n, nodes[n].gen };
+}
+
+bool TimingWheel::IsPending(const TimerId& id) const
+{
+	return id.idx >= 0 && id.idx < (int)nodes.size() && nodes[id.idx].gen == id.gen && nodes[id.idx].slot >= 0;
+}
+
+void TimingWheel::Cancel(TimerId& id)
+{
+	if (IsPending(id))
+	{
+		Unlink(id.idx);
+		FreeNode(id.idx);
+		--numPending;
+	}
+	id = TimerId{};
+}
+
+void TimingWheel::Place(int n)
+{
+	const unsigned int due = nodes[n].due;
+	assert(due >= curTick);
+	const unsigned int delta = due - curTick;
+	int level = 0;
+	while (level < GC::WHEEL_LEVELS - 1 && delta >= (1u << (GC::WHEEL_BITS * (level + 1))))
+		++level;
+	int idx = (due >> (GC::WHEEL_BITS * level)) & MASK;
+	Link(n, level * SLOTS + idx);
+}
+
+void TimingWheel::Link(int n, int slot)
+{
+	Node& node = nodes[n];
+	node.slot = slot;
+	node.prev = tails[slot];
+	node.next = -1;
+	if (tails[slot] >= 0)
+		nodes[tails[slot]].next = n;
+	else
+		heads[slot] = n;
+	tails[slot] = n;
+}
+
+void TimingWheel::Unlink(int n)
+{
+	Node& node = nodes[n];
+	if (node.prev >= 0)
+		nodes[node.prev].next = node.next;
+	else
+		heads[node.slot] = node.next;
+	if (node.next >= 0)
+		nodes[node.next].prev = node.prev;
+	else
+		tails[node.slot] = node.prev;
+	node.slot = -1;
+}
+
+void TimingWheel::FreeNode(int n)
+{
+	Node& node = nodes[n];
+	node.slot = -1;
+	node.gen++;
+	node.next = freeHead;
+	freeHead = n;
+}
+
+void TimingWheel::Cascade(int level, int idx)
+{
+	int slot = level * SLOTS + idx;
+	int n = heads[slot];
+	heads[slot] = tails[slot] = -1;
+	while (n >= 0)
+	{
+		int next = nodes[n].next;
+		Place(n);
+		n = next;
+	}
+}
+
+void TimingWheel::Tick(vector<GameEvent>& due)
+{
+	++curTick;
+	int idx = curTick & MASK;
+	//level 0 has gone all the way round, bring the next block of ticks down
+	if (idx == 0)
+		for (int level = 1; level < GC::WHEEL_LEVELS; ++level)
+		{
+			int li = (curTick >> (GC::WHEEL_BITS * level)) & MASK;
+			Cascade(level, li);
+			if (li != 0)
+				break;
+		}
+	while (heads[idx] >= 0)
+	{
+		int n = heads[idx];
+		assert(nodes[n].due == curTick);
+		due.push_back(nodes[n].ev);
+		Unlink(n);
+		FreeNode(n);
+		--numPending;
+	}
+}
+
+void TimingWheel::Advance(float now, vector<GameEvent>& due)
+{
+	unsigned int target = (unsigned int)floorf(max(now, 0.f) / GC::SCHED_TICK);
+	while (curTick < target)
+		Tick(due);
+}
+
+void TimingWheel::Save(Snapshot& snap) const
+{
+	snap.WriteArray(nodes.data(), nodes.size());
+	snap.Write(heads);
+	snap.Write(tails);
+	snap.Write(freeHead);
+	snap.Write(curTick);
+	snap.Write(numPending);
+}
+
+void TimingWheel::Load(Snapshot& snap)
+{
+	snap.ReadArray(nodes);
+	snap.Read(heads);
+	snap.Read(tails);
+	snap.Read(freeHead);
+	snap.Read(curTick);
+	snap.Read(numPending);
+	if (!IsValid())
+		snap.Fail();
+}
+
+bool TimingWheel::IsValid() const
+{
+	const int num = (int)nodes.size();
+	auto valid = [num](int n) { return n >= -1 && n < num; };
+	if (!valid(freeHead) || numPending < 0 || numPending > num)
+		return false;
+	//walk every list, counting so a loop can't go round forever
+	int seen = 0, pending = 0;
+	for (int s = 0; s < GC::WHEEL_LEVELS * SLOTS; ++s)
+	{
+		if (!valid(heads[s]) || !valid(tails[s]) || (heads[s] < 0) != (tails[s] < 0))
+			return false;
+		const int level = s / SLOTS, idx = s % SLOTS, shift = GC::WHEEL_BITS * level;
+		int prev = -1;
+		for (int n = heads[s]; n >= 0; n = nodes[n].next)
+		{
+			const Node& node = nodes[n];
+			if (++seen > num || !valid(node.next) || node.slot != s || node.prev != prev)
+				return false;
+			//due in the future, in this slot's block and not so far ahead it belongs a level up
+			if ((node.due >> shift) <= (curTick >> shift) || (int)((node.due >> shift) & MASK) != idx
+				|| node.due - curTick >= (1u << (shift + GC::WHEEL_BITS)))
+				return false;
+			prev = n;
+			++pending;
+		}
+		if (prev != tails[s])
+			return false;
+	}
+	for (int n = freeHead; n >= 0; n = nodes[n].next)
+		if (++seen > num || !valid(nodes[n].next) || nodes[n].slot != -1)
+			return false;
+	return seen == num && pending == numPending;
+}
+
+void SpawnTimer::Reset(TimingWheel& wheel, float now, float _delay, float _decayDelay, float _decayMultiplier) {
+	delay = originalDelay;
+	if (_delay != -1)
+		originalDelay = delay = _delay;
+	if (_decayDelay != -1)
+		decayDelay = _decayDelay;
+	if (_decayMultiplier != -1)
+		decayMultiplier = _decayMultiplier;
+	wheel.Cancel(id);
+	id = wheel.Schedule(now + GetWait(), ev);
+}
+
+void SpawnTimer::Retry(TimingWheel& wheel, float now) {
+	wheel.Cancel(id);
+	id = wheel.Schedule(now, ev);
+}
+
+float SpawnTimer::GetWait() const {
+	if (decayDelay <= 0)
+		return delay;
+	//the same as counting down a frame at a time, the delay shrinks each time decayDelay passes
+	float d = delay;
+	int k = 1;
+	while (k * decayDelay <= d)
+	{
+		d *= decayMultiplier;
+		++k;
+	}
+	return max(d, (k - 1) * decayDelay);
+}
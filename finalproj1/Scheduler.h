@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+
+#include "Snapshot.h"
+
+namespace GC
+{
+	const float SCHED_TICK = 1.f / 120.f;	//seconds per wheel tick, events are never early but can be up to this late
+	const int WHEEL_BITS = 6;				//each level of the wheel has 64 slots
+	const int WHEEL_LEVELS = 4;				//64^4 ticks, about 38 hours ahead
+}
+
+/*
+Something that should happen at a set time, the scheduler holds on to it
+and hands it back when it's due
+*/
+struct GameEvent {
+	enum class EvT { SpawnRock, SpawnEnemy, EnemyFire, ProjectileExpire };
+	EvT type;
+	unsigned int obj = 0;	//index into the objects array if it's about an object, a projectile's id for ProjectileExpire
+};
+
+//a handle to a scheduled event, the generation stops an old handle cancelling a reused slot
+struct TimerId {
+	int idx = -1;
+	unsigned int gen = 0;
+};
+
+/*
+Hierarchical timing wheel (Varghese and Lauck). Level 0 has a slot for each
+of the next 64 ticks, level 1 a slot for each of the next 64 blocks of 64
+ticks and so on. Scheduling drops an event straight into its slot and
+cancelling unlinks it, both O(1). Each tick only the one level 0 slot due is
+looked at, and every 64 ticks a higher slot is spread down into the level
+below. So thousands of pending cooldowns cost nothing on the frames where
+none of them are due.
+Events come out in the order they went in when due on the same tick, and
+everything is plain data so the wheel goes into snapshots as it is
+*/
+struct TimingWheel {
+	static const int SLOTS = 1 << GC::WHEEL_BITS;
+	static const int MASK = SLOTS - 1;
+
+	//one scheduled event, linked into the list for its slot, or the free list
+	struct Node {
+		GameEvent ev;
+		unsigned int due;		//tick to fire on
+		int prev, next;			//neighbours in the slot's list, -1 at the ends
+		int slot;				//which list it's in, -1 if free
+		unsigned int gen;		//bumped every time the node is freed
+	};
+	std::vector<Node> nodes;
+	int heads[GC::WHEEL_LEVELS * SLOTS];	//first node in each slot's list
+	int tails[GC::WHEEL_LEVELS * SLOTS];	//last node, new ones go on the end
+	int freeHead = -1;				//unused nodes
+	unsigned int curTick = 0;		//every tick up to and including this one has been done
+	int numPending = 0;
+
+	TimingWheel() {
+		Clear();
+	}
+	//make room for this many pending events so scheduling mid game doesn't allocate
+	void Reserve(size_t num) {
+		nodes.reserve(num);
+	}
+	//forget everything and go back to time zero
+	void Clear();
+	/*
+	time - game seconds when it should happen, anything in the past happens on the next tick
+	ev - what to hand back
+	returns - handle for cancelling it
+	*/
+	TimerId Schedule(float time, const GameEvent& ev);
+	//stop a pending event from happening, fine to pass one that has already gone off
+	void Cancel(TimerId& id);
+	bool IsPending(const TimerId& id) const;
+	/*
+	Run the clock up to this time
+	now - game seconds
+	due - everything that came due is added to the end, soonest first
+	*/
+	void Advance(float now, std::vector<GameEvent>& due);
+
+	void Save(Snapshot& snap) const;
+	//fails the snapshot if the lists don't link up, see IsValid
+	void Load(Snapshot& snap);
+	//every node is in exactly one list and every pending one is in the right slot for when it's due
+	bool IsValid() const;
+
+	//pick the level and slot for a node, relative to curTick
+	void Place(int n);
+	void Link(int n, int slot);
+	void Unlink(int n);
+	void FreeNode(int n);
+	//move everything in one slot down to lower levels
+	void Cascade(int level, int idx);
+	//one step of the clock
+	void Tick(std::vector<GameEvent>& due);
+};
+
+/*
+A crude attempt to control difficulty - there are many ways to do that!
+Things get created or spawned at timed regular intervals
+The rate at which these spawn events happen gets faster and
+faster to make the game get harder and harder.
+Rather than being polled every frame it puts its event on the scheduler
+and works out up front when that should be, allowing for the speed up
+*/
+struct SpawnTimer {
+	float delay=1, originalDelay=1;	//how long to wait before the next spawn
+	float decayDelay = 0;			//how long to wait before the spawning gets faster
+	float decayMultiplier = 0.99f;  //when spawning gets faster, by what percentage does the delay fall
+	GameEvent ev;					//what to raise when it goes off
+	TimerId id;						//its event on the scheduler
+
+	/*
+	Restart the clocks, we can do that by specifying all new delay/decay
+	time values, or leave that blank, it will remember the old values
+	and just restart the timers.
+	wheel - where to schedule the next spawn
+	now - game time the wait starts from
+	*/
+	void Reset(TimingWheel& wheel, float now, float _delay = -1, float _decayDelay = -1, float _decayMultiplier = -1);
+	//the spawn didn't work out, try again next tick without restarting the clocks
+	void Retry(TimingWheel& wheel, float now);
+	/*
+	How long after a reset it goes off. Every decayDelay seconds of waiting
+	the delay shrinks by decayMultiplier, so a long wait ends early
+	*/
+	float GetWait() const;
+};
@@ -0,0 +1,27 @@
+#include <fstream>
+
+#include "Snapshot.h"
+
+using namespace std;
+
+bool Snapshot::SaveToFile(const string& path) const
+{
+	ofstream fs(path, ios::binary);
+	if (!fs.is_open())
+		return false;
+	fs.write(data.data(), data.size());
+	return !fs.fail();
+}
+
+bool Snapshot::LoadFromFile(const string& path)
+{
+	ifstream fs(path, ios::binary | ios::ate);
+	if (!fs.is_open())
+		return false;
+	streamoff sz = fs.tellg();
+	fs.seekg(0);
+	Clear();
+	data.resize((size_t)sz);
+	fs.read(data.data(), sz);
+	return !fs.fail();
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstring>
+#include <type_traits>
+#include <assert.h>
+
+/*
+The state of a game at one moment as raw bytes, see Game::SaveSnapshot.
+Values are written and read back in the same order, so there are no
+names or padding and restoring is little more than a few memcpys.
+Clear keeps the memory, so reusing a snapshot doesn't allocate.
+Snapshots can come from a file, so reading never goes past the end: a read
+that doesn't fit, or a Load that finds something impossible, marks the
+snapshot as failed and everything read after that is zero
+*/
+struct Snapshot {
+	std::vector<char> data;
+	size_t readPos = 0;		//how far Read has got
+	bool failed = false;	//something didn't fit or made no sense, see Fail
+
+	void Clear() {
+		data.clear();
+		readPos = 0;
+		failed = false;
+	}
+	//go back to the start to read it again
+	void StartRead() {
+		readPos = 0;
+		failed = false;
+	}
+	//the data is wrong, stop reading it
+	void Fail() {
+		failed = true;
+		readPos = data.size();
+	}
+	//every read fitted and nothing is left over
+	bool ReadOK() const {
+		return !failed && readPos == data.size();
+	}
+	template<typename T>
+	void Write(const T& val) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain data can go in a snapshot");
+		const char *p = reinterpret_cast<const char*>(&val);
+		data.insert(data.end(), p, p + sizeof(T));
+	}
+	template<typename T>
+	void WriteArray(const T *pVals, size_t num) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain data can go in a snapshot");
+		Write(num);
+		const char *p = reinterpret_cast<const char*>(pVals);
+		data.insert(data.end(), p, p + num * sizeof(T));
+	}
+	template<typename T>
+	void Read(T& val) {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain data can come out of a snapshot");
+		if (data.size() - readPos < sizeof(T))
+		{
+			Fail();
+			memset(&val, 0, sizeof(T));
+			return;
+		}
+		memcpy(&val, &data[readPos], sizeof(T));
+		readPos += sizeof(T);
+	}
+	//read back a WriteArray into a vector, resizing it to fit
+	template<typename T>
+	void ReadArray(std::vector<T>& vals) {
+		size_t num = 0;
+		Read(num);
+		if (num > (data.size() - readPos) / sizeof(T))
+		{
+			Fail();
+			num = 0;
+		}
+		vals.resize(num);
+		if (num > 0)
+			memcpy(vals.data(), &data[readPos], num * sizeof(T));
+		readPos += num * sizeof(T);
+	}
+	//read back a WriteArray into memory that's already there, returns how many were read
+	template<typename T>
+	size_t ReadArray(T *pVals, size_t maxNum) {
+		size_t num = 0;
+		Read(num);
+		if (num > maxNum || num > (data.size() - readPos) / sizeof(T))
+		{
+			Fail();
+			num = 0;
+		}
+		if (num > 0)
+			memcpy(pVals, &data[readPos], num * sizeof(T));
+		readPos += num * sizeof(T);
+		return num;
+	}
+	bool Empty() const {
+		return data.empty();
+	}
+	bool SaveToFile(const std::string& path) const;
+	bool LoadFromFile(const std::string& path);
+};
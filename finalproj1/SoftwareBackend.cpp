@@ -0,0 +1,431 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "SoftwareBackend.h"
+#include "WorkerPool.h"
+
+using namespace sf;
+using namespace std;
+
+/*
+The built in font, one row of 8 pixels per byte (top bit on the left),
+GC::FONT_H rows per character from GC::FONT_FIRST to GC::FONT_LAST.
+A monospaced sans rendered at 13 pixels
+*/
+const unsigned char FONT_ROWS[GC::FONT_LAST - GC::FONT_FIRST + 1][GC::FONT_H]{
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },	//space
+	{ 0x00,0x00,0x10,0x10,0x10,0x10,0x10,0x10,0x00,0x10,0x10,0x00,0x00,0x00 },	//!
+	{ 0x00,0x00,0x28,0x28,0x28,0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },	//"
+	{ 0x00,0x12,0x12,0x16,0x7F,0x24,0x24,0xFE,0x28,0x48,0x48,0x00,0x00,0x00 },	//#
+	{ 0x00,0x00,0x08,0x3E,0x49,0x48,0x38,0x0E,0x09,0x49,0x3E,0x08,0x08,0x00 },	//$
+	{ 0x00,0x00,0x60,0x90,0x90,0x62,0x1C,0x66,0x09,0x09,0x06,0x00,0x00,0x00 },	//%
+	{ 0x00,0x00,0x1C,0x20,0x20,0x30,0x49,0x4D,0x45,0x62,0x3D,0x00,0x00,0x00 },	//&
+	{ 0x00,0x00,0x10,0x10,0x10,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },	//'
+	{ 0x0C,0x08,0x08,0x10,0x10,0x10,0x10,0x10,0x10,0x08,0x08,0x04,0x00,0x00 },	//(
+	{ 0x30,0x10,0x10,0x08,0x08,0x08,0x08,0x08,0x08,0x10,0x10,0x30,0x00,0x00 },	//)
+	{ 0x00,0x00,0x08,0x49,0x3E,0x1C,0x6B,0x08,0x00,0x00,0x00,0x00,0x00,0x00 },	//*
+	{ 0x00,0x00,0x00,0x10,0x10,0x10,0xFE,0x10,0x10,0x10,0x00,0x00,0x00,0x00 },	//+
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x10,0x20,0x00 },	//,
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x00,0x00,0x00 },	//-
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00 },	//.
+	{ 0x00,0x00,0x02,0x04,0x04,0x08,0x08,0x18,0x10,0x10,0x20,0x20,0x40,0x00 },	///
+	{ 0x00,0x00,0x1C,0x22,0x41,0x41,0x49,0x41,0x41,0x22,0x1C,0x00,0x00,0x00 },	//0
+	{ 0x00,0x00,0x38,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x3E,0x00,0x00,0x00 },	//1
+	{ 0x00,0x00,0x3E,0x43,0x01,0x01,0x02,0x0C,0x18,0x20,0x7F,0x00,0x00,0x00 },	//2
+	{ 0x00,0x00,0x3E,0x41,0x01,0x03,0x1C,0x03,0x01,0x43,0x3E,0x00,0x00,0x00 },	//3
+	{ 0x00,0x00,0x06,0x0A,0x1A,0x12,0x22,0x42,0x7F,0x02,0x02,0x00,0x00,0x00 },	//4
+	{ 0x00,0x00,0x7E,0x40,0x40,0x7C,0x03,0x01,0x01,0x43,0x3C,0x00,0x00,0x00 },	//5
+	{ 0x00,0x00,0x1E,0x21,0x40,0x5E,0x63,0x41,0x41,0x23,0x1E,0x00,0x00,0x00 },	//6
+	{ 0x00,0x00,0x7F,0x02,0x02,0x04,0x04,0x08,0x18,0x10,0x20,0x00,0x00,0x00 },	//7
+	{ 0x00,0x00,0x3E,0x41,0x41,0x41,0x3E,0x63,0x41,0x61,0x3E,0x00,0x00,0x00 },	//8
+	{ 0x00,0x00,0x3C,0x62,0x41,0x41,0x63,0x3D,0x01,0x42,0x3C,0x00,0x00,0x00 },	//9
+	{ 0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00 },	//:
+	{ 0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x18,0x18,0x10,0x20,0x00 },	//;
+	{ 0x00,0x00,0x00,0x00,0x01,0x0E,0x70,0x70,0x0E,0x01,0x00,0x00,0x00,0x00 },	//<
+	{ 0x00,0x00,0x00,0x00,0x00,0x7F,0x00,0x00,0x7F,0x00,0x00,0x00,0x00,0x00 },	//=
+	{ 0x00,0x00,0x00,0x00,0x40,0x38,0x07,0x07,0x38,0x40,0x00,0x00,0x00,0x00 },	//>
+	{ 0x00,0x00,0x38,0x44,0x04,0x08,0x10,0x10,0x00,0x10,0x10,0x00,0x00,0x00 },	//?
+	{ 0x00,0x00,0x1E,0x33,0x21,0x47,0x49,0x49,0x49,0x47,0x20,0x30,0x1E,0x00 },	//@
+	{ 0x00,0x00,0x08,0x14,0x14,0x14,0x22,0x22,0x3E,0x63,0x41,0x00,0x00,0x00 },	//A
+	{ 0x00,0x00,0x7E,0x41,0x41,0x41,0x7E,0x41,0x41,0x41,0x7E,0x00,0x00,0x00 },	//B
+	{ 0x00,0x00,0x1E,0x21,0x40,0x40,0x40,0x40,0x40,0x21,0x1E,0x00,0x00,0x00 },	//C
+	{ 0x00,0x00,0x7C,0x42,0x41,0x41,0x41,0x41,0x41,0x42,0x7C,0x00,0x00,0x00 },	//D
+	{ 0x00,0x00,0x7F,0x40,0x40,0x40,0x7F,0x40,0x40,0x40,0x7F,0x00,0x00,0x00 },	//E
+	{ 0x00,0x00,0x7F,0x40,0x40,0x40,0x7F,0x40,0x40,0x40,0x40,0x00,0x00,0x00 },	//F
+	{ 0x00,0x00,0x1E,0x21,0x40,0x40,0x43,0x41,0x41,0x21,0x1E,0x00,0x00,0x00 },	//G
+	{ 0x00,0x00,0x41,0x41,0x41,0x41,0x7F,0x41,0x41,0x41,0x41,0x00,0x00,0x00 },	//H
+	{ 0x00,0x00,0x7C,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x7C,0x00,0x00,0x00 },	//I
+	{ 0x00,0x00,0x1C,0x04,0x04,0x04,0x04,0x04,0x04,0x44,0x38,0x00,0x00,0x00 },	//J
+	{ 0x00,0x00,0x42,0x44,0x48,0x50,0x70,0x48,0x44,0x44,0x42,0x00,0x00,0x00 },	//K
+	{ 0x00,0x00,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x40,0x7F,0x00,0x00,0x00 },	//L
+	{ 0x00,0x00,0x63,0x63,0x55,0x55,0x55,0x49,0x41,0x41,0x41,0x00,0x00,0x00 },	//M
+	{ 0x00,0x00,0x61,0x61,0x51,0x51,0x49,0x45,0x45,0x43,0x43,0x00,0x00,0x00 },	//N
+	{ 0x00,0x00,0x1C,0x22,0x41,0x41,0x41,0x41,0x41,0x22,0x1C,0x00,0x00,0x00 },	//O
+	{ 0x00,0x00,0x7E,0x43,0x41,0x41,0x43,0x7E,0x40,0x40,0x40,0x00,0x00,0x00 },	//P
+	{ 0x00,0x00,0x1C,0x22,0x41,0x41,0x41,0x41,0x41,0x23,0x1E,0x06,0x02,0x00 },	//Q
+	{ 0x00,0x00,0xFC,0x86,0x82,0x82,0xFC,0x84,0x82,0x82,0x81,0x00,0x00,0x00 },	//R
+	{ 0x00,0x00,0x3E,0x61,0x40,0x60,0x3E,0x03,0x01,0x43,0x3E,0x00,0x00,0x00 },	//S
+	{ 0x00,0x00,0xFE,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x00,0x00,0x00 },	//T
+	{ 0x00,0x00,0x41,0x41,0x41,0x41,0x41,0x41,0x41,0x41,0x3E,0x00,0x00,0x00 },	//U
+	{ 0x00,0x00,0x41,0x63,0x22,0x22,0x22,0x14,0x14,0x14,0x08,0x00,0x00,0x00 },	//V
+	{ 0x00,0x00,0x81,0x81,0x81,0x5A,0x5A,0x5A,0x66,0x66,0x66,0x00,0x00,0x00 },	//W
+	{ 0x00,0x00,0x63,0x22,0x14,0x1C,0x08,0x14,0x36,0x22,0x41,0x00,0x00,0x00 },	//X
+	{ 0x00,0x00,0x82,0x44,0x28,0x28,0x10,0x10,0x10,0x10,0x10,0x00,0x00,0x00 },	//Y
+	{ 0x00,0x00,0x7F,0x03,0x06,0x04,0x08,0x10,0x30,0x60,0x7F,0x00,0x00,0x00 },	//Z
+	{ 0x1C,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x1C,0x00,0x00 },	//[
+	{ 0x00,0x00,0x40,0x20,0x20,0x10,0x10,0x18,0x08,0x08,0x04,0x04,0x02,0x00 },	//backslash
+	{ 0x38,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x38,0x00,0x00 },	//]
+	{ 0x00,0x00,0x10,0x28,0x44,0xC6,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },	//^
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFF },	//_
+	{ 0x00,0x10,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },	//`
+	{ 0x00,0x00,0x00,0x00,0x1C,0x22,0x02,0x3E,0x42,0x46,0x3A,0x00,0x00,0x00 },	//a
+	{ 0x40,0x40,0x40,0x40,0x7C,0x66,0x42,0x42,0x42,0x66,0x7C,0x00,0x00,0x00 },	//b
+	{ 0x00,0x00,0x00,0x00,0x1C,0x22,0x40,0x40,0x40,0x22,0x1C,0x00,0x00,0x00 },	//c
+	{ 0x02,0x02,0x02,0x02,0x3E,0x66,0x42,0x42,0x42,0x66,0x3E,0x00,0x00,0x00 },	//d
+	{ 0x00,0x00,0x00,0x00,0x3C,0x66,0x42,0x7E,0x40,0x62,0x3C,0x00,0x00,0x00 },	//e
+	{ 0x0C,0x10,0x10,0x10,0x7C,0x10,0x10,0x10,0x10,0x10,0x10,0x00,0x00,0x00 },	//f
+	{ 0x00,0x00,0x00,0x00,0x3E,0x66,0x42,0x42,0x42,0x66,0x3A,0x02,0x22,0x1C },	//g
+	{ 0x40,0x40,0x40,0x40,0x5C,0x62,0x42,0x42,0x42,0x42,0x42,0x00,0x00,0x00 },	//h
+	{ 0x10,0x00,0x00,0x00,0x70,0x10,0x10,0x10,0x10,0x10,0x7C,0x00,0x00,0x00 },	//i
+	{ 0x08,0x00,0x00,0x00,0x38,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x70 },	//j
+	{ 0x40,0x40,0x40,0x40,0x44,0x48,0x50,0x70,0x48,0x44,0x42,0x00,0x00,0x00 },	//k
+	{ 0x70,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x0E,0x00,0x00,0x00 },	//l
+	{ 0x00,0x00,0x00,0x00,0x7F,0x49,0x49,0x49,0x49,0x49,0x49,0x00,0x00,0x00 },	//m
+	{ 0x00,0x00,0x00,0x00,0x5C,0x62,0x42,0x42,0x42,0x42,0x42,0x00,0x00,0x00 },	//n
+	{ 0x00,0x00,0x00,0x00,0x3C,0x66,0x42,0x42,0x42,0x66,0x3C,0x00,0x00,0x00 },	//o
+	{ 0x00,0x00,0x00,0x00,0x7C,0x66,0x42,0x42,0x42,0x66,0x7C,0x40,0x40,0x40 },	//p
+	{ 0x00,0x00,0x00,0x00,0x3E,0x66,0x42,0x42,0x42,0x66,0x3A,0x02,0x02,0x02 },	//q
+	{ 0x00,0x00,0x00,0x00,0x3C,0x32,0x20,0x20,0x20,0x20,0x20,0x00,0x00,0x00 },	//r
+	{ 0x00,0x00,0x00,0x00,0x3C,0x42,0x40,0x3C,0x02,0x42,0x3C,0x00,0x00,0x00 },	//s
+	{ 0x00,0x00,0x10,0x10,0x7E,0x10,0x10,0x10,0x10,0x10,0x0E,0x00,0x00,0x00 },	//t
+	{ 0x00,0x00,0x00,0x00,0x42,0x42,0x42,0x42,0x42,0x46,0x3A,0x00,0x00,0x00 },	//u
+	{ 0x00,0x00,0x00,0x00,0x42,0x66,0x24,0x24,0x3C,0x18,0x18,0x00,0x00,0x00 },	//v
+	{ 0x00,0x00,0x00,0x00,0x81,0x81,0x5A,0x5A,0x5A,0x24,0x24,0x00,0x00,0x00 },	//w
+	{ 0x00,0x00,0x00,0x00,0x66,0x24,0x18,0x18,0x18,0x24,0x66,0x00,0x00,0x00 },	//x
+	{ 0x00,0x00,0x00,0x00,0x42,0x22,0x24,0x24,0x14,0x18,0x08,0x08,0x10,0x30 },	//y
+	{ 0x00,0x00,0x00,0x00,0x7E,0x02,0x04,0x18,0x20,0x40,0x7E,0x00,0x00,0x00 },	//z
+	{ 0x1C,0x10,0x10,0x10,0x10,0x60,0x10,0x10,0x10,0x10,0x10,0x0C,0x00,0x00 },	//{
+	{ 0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x00 },	//|
+	{ 0x70,0x10,0x10,0x10,0x10,0x0C,0x10,0x10,0x10,0x10,0x10,0x60,0x00,0x00 },	//}
+	{ 0x00,0x00,0x00,0x00,0x00,0x00,0x39,0x46,0x00,0x00,0x00,0x00,0x00,0x00 },	//~
+};
+
+SoftwareBackend::SoftwareBackend(unsigned width, unsigned height, WorkerPool *pPool)
+	: size(width, height), pWorkers(pPool)
+{
+	pixels.resize(width * height * 4);
+	Clear();
+	const int numChars = GC::FONT_LAST - GC::FONT_FIRST + 1;
+	fontImg.create(numChars * GC::FONT_W, GC::FONT_H, Color::Transparent);
+	for (int c = 0; c < numChars; ++c)
+		for (int y = 0; y < GC::FONT_H; ++y)
+			for (int x = 0; x < GC::FONT_W; ++x)
+				if (FONT_ROWS[c][y] & (0x80 >> x))
+					fontImg.setPixel(c * GC::FONT_W + x, y, Color::White);
+}
+
+void SoftwareBackend::Clear(const Color& col)
+{
+	//anything not drawn yet would be covered up anyway
+	tris.clear();
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		pixels[i] = col.r;
+		pixels[i + 1] = col.g;
+		pixels[i + 2] = col.b;
+		pixels[i + 3] = col.a;
+	}
+}
+
+const Image* SoftwareBackend::FindImage(const Texture *pTex)
+{
+	if (!pTex)
+		return nullptr;
+	auto it = images.find(pTex);
+	//copying it back from the graphics card isn't an option, there may not be one
+	assert(it != images.end());
+	return (it != images.end()) ? &it->second : nullptr;
+}
+
+void SoftwareBackend::AddTri(const SVert& a, const SVert& b, const SVert& c, const Image *pTex, bool additive)
+{
+	Tri t{ { a, b, c }, pTex, additive };
+	tris.push_back(t);
+}
+
+void SoftwareBackend::AddLine(const SVert& a, const SVert& b, bool additive)
+{
+	//half a pixel either side of the line
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float len = sqrtf(dx * dx + dy * dy);
+	if (len <= 0)
+		return;
+	float nx = -dy / len * 0.5f, ny = dx / len * 0.5f;
+	SVert a0 = a, a1 = a, b0 = b, b1 = b;
+	a0.x += nx; a0.y += ny;
+	a1.x -= nx; a1.y -= ny;
+	b0.x += nx; b0.y += ny;
+	b1.x -= nx; b1.y -= ny;
+	AddTri(a0, b0, b1, nullptr, additive);
+	AddTri(a0, b1, a1, nullptr, additive);
+}
+
+void SoftwareBackend::Draw(const Sprite& spr, const RenderStates& states)
+{
+	const IntRect& tr = spr.getTextureRect();
+	Transform t = states.transform * spr.getTransform();
+	float w = (float)abs(tr.width), h = (float)abs(tr.height);
+	float u0 = (float)tr.left, v0 = (float)tr.top;
+	float u1 = u0 + tr.width, v1 = v0 + tr.height;
+	const Color& col = spr.getColor();
+	SVert corners[4];
+	const float local[4][4]{ { 0,0,u0,v0 },{ w,0,u1,v0 },{ w,h,u1,v1 },{ 0,h,u0,v1 } };
+	for (int i = 0; i < 4; ++i)
+	{
+		Vector2f p = t.transformPoint(local[i][0], local[i][1]);
+		corners[i] = SVert{ p.x, p.y, local[i][2], local[i][3], col };
+	}
+	const Image *pImg = FindImage(spr.getTexture());
+	bool additive = states.blendMode == BlendAdd;
+	AddTri(corners[0], corners[1], corners[2], pImg, additive);
+	AddTri(corners[0], corners[2], corners[3], pImg, additive);
+	stats.drawCalls++;
+}
+
+Vector2f SoftwareBackend::TextSize(const Text& txt) const
+{
+	const String& str = txt.getString();
+	const float scale = txt.getCharacterSize() / GC::FONT_EM;
+	int lines = 1, cols = 0, widest = 0;
+	for (size_t i = 0; i < str.getSize(); ++i)
+	{
+		if (str[i] == '\n')
+		{
+			++lines;
+			cols = 0;
+		}
+		else
+			widest = max(widest, ++cols);
+	}
+	return Vector2f(widest * GC::FONT_W * scale, lines * GC::FONT_H * scale);
+}
+
+void SoftwareBackend::Draw(const Text& txt)
+{
+	const String& str = txt.getString();
+	if (str.isEmpty())
+		return;
+	//a fixed grid of characters, scaled up from the size the font was made at
+	const float scale = txt.getCharacterSize() / GC::FONT_EM;
+	const float w = GC::FONT_W * scale, h = GC::FONT_H * scale;
+	const Transform& t = txt.getTransform();
+	const Color& col = txt.getFillColor();
+	float x = 0, y = 0;
+	for (size_t i = 0; i < str.getSize(); ++i)
+	{
+		Uint32 c = str[i];
+		if (c == '\n')
+		{
+			y += h;
+			x = 0;
+			continue;
+		}
+		if (c > (Uint32)GC::FONT_FIRST && c <= (Uint32)GC::FONT_LAST)
+		{
+			float u0 = (float)((c - GC::FONT_FIRST) * GC::FONT_W), u1 = u0 + GC::FONT_W;
+			float v0 = 0, v1 = (float)GC::FONT_H;
+			Vector2f p0 = t.transformPoint(x, y), p1 = t.transformPoint(x + w, y);
+			Vector2f p2 = t.transformPoint(x + w, y + h), p3 = t.transformPoint(x, y + h);
+			SVert a{ p0.x, p0.y, u0, v0, col }, b{ p1.x, p1.y, u1, v0, col };
+			SVert d{ p2.x, p2.y, u1, v1, col }, e{ p3.x, p3.y, u0, v1, col };
+			AddTri(a, b, d, &fontImg, false);
+			AddTri(a, d, e, &fontImg, false);
+		}
+		x += w;
+	}
+	stats.drawCalls++;
+}
+
+void SoftwareBackend::DrawAligned(const Text& txt, const Vector2f& align)
+{
+	//measured in the built in font, the sf::Font's glyphs would need the graphics card
+	Text aligned(txt);
+	Vector2f sz = TextSize(txt);
+	aligned.setOrigin(sz.x * align.x, sz.y * align.y);
+	Draw(aligned);
+}
+
+void SoftwareBackend::Draw(const VertexArray& verts, const RenderStates& states)
+{
+	const size_t num = verts.getVertexCount();
+	if (num == 0)
+		return;
+	const Image *pImg = FindImage(states.texture);
+	bool additive = states.blendMode == BlendAdd;
+	auto sv = [&](size_t i) {
+		const Vertex& v = verts[i];
+		Vector2f p = states.transform.transformPoint(v.position);
+		return SVert{ p.x, p.y, v.texCoords.x, v.texCoords.y, v.color };
+	};
+	switch (verts.getPrimitiveType())
+	{
+	case Points:
+		for (size_t i = 0; i < num; ++i)
+		{
+			SVert a = sv(i), b = a;
+			a.x -= 0.5f;
+			b.x += 0.5f;
+			AddLine(a, b, additive);
+		}
+		break;
+	case Lines:
+		for (size_t i = 0; i + 1 < num; i += 2)
+			AddLine(sv(i), sv(i + 1), additive);
+		break;
+	case LineStrip:
+		for (size_t i = 0; i + 1 < num; ++i)
+			AddLine(sv(i), sv(i + 1), additive);
+		break;
+	case Triangles:
+		for (size_t i = 0; i + 2 < num; i += 3)
+			AddTri(sv(i), sv(i + 1), sv(i + 2), pImg, additive);
+		break;
+	case TriangleStrip:
+		for (size_t i = 0; i + 2 < num; ++i)
+			AddTri(sv(i), sv(i + 1), sv(i + 2), pImg, additive);
+		break;
+	case TriangleFan:
+		for (size_t i = 1; i + 1 < num; ++i)
+			AddTri(sv(0), sv(i), sv(i + 1), pImg, additive);
+		break;
+	case Quads:
+		for (size_t i = 0; i + 3 < num; i += 4)
+		{
+			AddTri(sv(i), sv(i + 1), sv(i + 2), pImg, additive);
+			AddTri(sv(i), sv(i + 2), sv(i + 3), pImg, additive);
+		}
+		break;
+	default:
+		assert(false);
+	}
+	stats.drawCalls++;
+}
+
+long long SoftwareBackend::RasteriseBand(int y0, int y1)
+{
+	long long count = 0;
+	const int width = (int)size.x;
+	for (size_t i = 0; i < tris.size(); ++i)
+	{
+		const Tri& t = tris[i];
+		const SVert &a = t.v[0], &b = t.v[1], &c = t.v[2];
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (fabsf(area) < 1e-6f)
+			continue;
+		int minX = max(0, (int)floorf(min(a.x, min(b.x, c.x))));
+		int maxX = min(width - 1, (int)ceilf(max(a.x, max(b.x, c.x))));
+		int minY = max(y0, (int)floorf(min(a.y, min(b.y, c.y))));
+		int maxY = min(y1 - 1, (int)ceilf(max(a.y, max(b.y, c.y))));
+		if (minX > maxX || minY > maxY)
+			continue;
+		const float inv = 1.f / area;
+		const Uint8 *pTexels = t.pTex ? t.pTex->getPixelsPtr() : nullptr;
+		const int texW = t.pTex ? (int)t.pTex->getSize().x : 0, texH = t.pTex ? (int)t.pTex->getSize().y : 0;
+		for (int y = minY; y <= maxY; ++y)
+		{
+			//sample a hair off the pixel centre so a pixel on a shared edge only goes to one triangle
+			const float py = y + 0.50001f;
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const float px = x + 0.50002f;
+				float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inv;
+				float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inv;
+				float w2 = 1.f - w0 - w1;
+				if (w0 < 0 || w1 < 0 || w2 < 0)
+					continue;
+
+				float src[4]{
+					w0 * a.col.r + w1 * b.col.r + w2 * c.col.r,
+					w0 * a.col.g + w1 * b.col.g + w2 * c.col.g,
+					w0 * a.col.b + w1 * b.col.b + w2 * c.col.b,
+					w0 * a.col.a + w1 * b.col.a + w2 * c.col.a };
+				if (pTexels && texW > 0 && texH > 0)
+				{
+					int tx = (int)floorf(w0 * a.u + w1 * b.u + w2 * c.u) % texW;
+					int ty = (int)floorf(w0 * a.v + w1 * b.v + w2 * c.v) % texH;
+					tx = (tx < 0) ? tx + texW : tx;
+					ty = (ty < 0) ? ty + texH : ty;
+					const Uint8 *pT = pTexels + (ty * texW + tx) * 4;
+					for (int ch = 0; ch < 4; ++ch)
+						src[ch] = src[ch] * pT[ch] / 255.f;
+				}
+				const float alpha = src[3] / 255.f;
+				Uint8 *pDst = &pixels[(y * width + x) * 4];
+				for (int ch = 0; ch < 3; ++ch)
+				{
+					float v = t.additive ? pDst[ch] + src[ch] * alpha : src[ch] * alpha + pDst[ch] * (1.f - alpha);
+					pDst[ch] = (Uint8)min(255.f, v + 0.5f);
+				}
+				float da = t.additive ? pDst[3] + src[3] : src[3] + pDst[3] * (1.f - alpha);
+				pDst[3] = (Uint8)min(255.f, da + 0.5f);
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+void RasteriseJob(void *pData, int job)
+{
+	SoftwareBackend& sb = *reinterpret_cast<SoftwareBackend*>(pData);
+	int y0 = job * sb.BAND_HEIGHT;
+	int y1 = min((int)sb.size.y, y0 + sb.BAND_HEIGHT);
+	sb.bandPixels[job] = sb.RasteriseBand(y0, y1);
+}
+
+void SoftwareBackend::Flush()
+{
+	if (tris.empty())
+		return;
+	int numBands = ((int)size.y + BAND_HEIGHT - 1) / BAND_HEIGHT;
+	bandPixels.assign(numBands, 0);
+	if (pWorkers)
+		pWorkers->Run(numBands, RasteriseJob, this);
+	else
+		for (int i = 0; i < numBands; ++i)
+			RasteriseJob(this, i);
+	for (int i = 0; i < numBands; ++i)
+		stats.pixels += bandPixels[i];
+	tris.clear();
+}
+
+Image SoftwareBackend::GetImage()
+{
+	Flush();
+	Image img;
+	img.create(size.x, size.y, pixels.data());
+	return img;
+}
+
+float CompareImages(const Image& a, const Image& b, int tolerance)
+{
+	if (a.getSize() != b.getSize())
+		return 1.f;
+	const Vector2u sz = a.getSize();
+	const size_t num = (size_t)sz.x * sz.y;
+	if (num == 0)
+		return 0;
+	const Uint8 *pA = a.getPixelsPtr(), *pB = b.getPixelsPtr();
+	size_t diff = 0;
+	for (size_t i = 0; i < num; ++i)
+	{
+		bool same = true;
+		for (int ch = 0; ch < 4 && same; ++ch)
+			same = abs((int)pA[i * 4 + ch] - (int)pB[i * 4 + ch]) <= tolerance;
+		if (!same)
+			++diff;
+	}
+	return (float)diff / num;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <string>
+
+#include "RenderBackend.h"
+
+struct WorkerPool;
+
+namespace GC
+{
+	const int FONT_W = 8;			//pixels across each character of the built in font
+	const int FONT_H = 14;			//pixels down, including room for descenders
+	const float FONT_EM = 13.f;		//the character size the font was made at, text is scaled from this
+	const char FONT_FIRST = ' ';	//printable ASCII, anything else is left as a gap
+	const char FONT_LAST = '~';
+}
+
+/*
+A CPU only renderer drawing into an RGBA buffer in memory, so render code
+can run on machines with no GPU or display and the results can be compared
+against saved golden images. Everything is turned into triangles as it's
+submitted and only rasterised when the pixels are wanted, the screen is
+split into horizontal bands and each band is done by a different thread.
+Nearest texel sampling, alpha or additive blending, no shaders.
+Nothing in here touches the graphics card: textures are drawn from images
+handed over with RegisterImage, and text uses a small built in bitmap font
+rather than sf::Font, whose glyphs only exist as a texture
+*/
+struct SoftwareBackend : public RenderBackend {
+	//one corner of a triangle, texture coordinates are in texels like sf::Vertex
+	struct SVert {
+		float x, y, u, v;
+		sf::Color col;
+	};
+	struct Tri {
+		SVert v[3];
+		const sf::Image *pTex;	//nullptr means just the vertex colours
+		bool additive;			//BlendAdd rather than BlendAlpha
+	};
+
+	const int BAND_HEIGHT = 32;			//rows in each job handed to a thread
+	sf::Vector2u size;
+	std::vector<sf::Uint8> pixels;		//RGBA, top row first
+	std::vector<Tri> tris;				//submitted but not drawn yet
+	std::map<const sf::Texture*, sf::Image> images;	//what to draw for each texture, see RegisterImage
+	sf::Image fontImg;					//the built in font, every character in a row, white on transparent
+	std::vector<long long> bandPixels;	//pixels drawn by each band, added to stats after a flush
+	WorkerPool *pWorkers = nullptr;		//optional, without it everything is done on the calling thread
+
+	SoftwareBackend(unsigned width, unsigned height, WorkerPool *pPool = nullptr);
+
+	sf::Vector2u GetSize() const override {
+		return size;
+	}
+	void Clear(const sf::Color& col = sf::Color::Black) override;
+	void Draw(const sf::Sprite& spr, const sf::RenderStates& states = sf::RenderStates::Default) override;
+	//text always uses the built in font, at the text's character size
+	void Draw(const sf::Text& txt) override;
+	void DrawAligned(const sf::Text& txt, const sf::Vector2f& align) override;
+	void Draw(const sf::VertexArray& verts, const sf::RenderStates& states = sf::RenderStates::Default) override;
+
+	/*
+	Use this image whenever the texture is drawn. Textures are only known by
+	their address, so forget them (ClearImages) before they are destroyed,
+	a new texture at the same address would get the old pixels
+	*/
+	void RegisterImage(const sf::Texture *pTex, const sf::Image& img) {
+		images[pTex] = img;
+	}
+	void ClearImages() {
+		images.clear();
+	}
+	//draw everything submitted so far
+	void Flush();
+	//flush then copy the pixels out, e.g. to save or compare
+	sf::Image GetImage();
+	bool SaveImage(const std::string& path) {
+		return GetImage().saveToFile(path);
+	}
+
+	//the registered image for a texture, nullptr draws just the vertex colours
+	const sf::Image* FindImage(const sf::Texture *pTex);
+	//width and height of a text in the built in font, before its transform
+	sf::Vector2f TextSize(const sf::Text& txt) const;
+	void AddTri(const SVert& a, const SVert& b, const SVert& c, const sf::Image *pTex, bool additive);
+	//a line becomes a quad one pixel wide
+	void AddLine(const SVert& a, const SVert& b, bool additive);
+	//draw every triangle over rows [y0,y1), returns pixels written
+	long long RasteriseBand(int y0, int y1);
+};
+
+/*
+How different two images are
+tolerance - how far apart (0-255) a channel can be before the pixel counts as different
+returns - fraction (0-1) of pixels that are different, 1 if the sizes don't match
+*/
+float CompareImages(const sf::Image& a, const sf::Image& b, int tolerance = 2);
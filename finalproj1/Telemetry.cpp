@@ -0,0 +1,185 @@
+#include <assert.h>
+#include <fstream>
+#include <algorithm>
+
+#include "Telemetry.h"
+
+using namespace std;
+
+const char* Telemetry::CHANNEL_NAMES[NUM_CHANNELS]{ "frame", "update", "render" };
+
+int TimeHistogram::Bucket(unsigned int us)
+{
+	if (us < 2 * SUB)
+		return (int)us;
+	int msb = 0;
+	while ((us >> msb) > 1)
+		++msb;
+	int shift = msb - SUB_BITS;
+	return (shift + 1) * SUB + (int)((us >> shift) - SUB);
+}
+
+unsigned int TimeHistogram::BucketLow(int b)
+{
+	if (b < 2 * SUB)
+		return (unsigned int)b;
+	int shift = b / SUB - 1;
+	return (unsigned int)(b % SUB + SUB) << shift;
+}
+
+unsigned int TimeHistogram::BucketHigh(int b)
+{
+	if (b < 2 * SUB)
+		return (unsigned int)b + 1;
+	int shift = b / SUB - 1;
+	return BucketLow(b) + (1u << shift);
+}
+
+void TimeHistogram::Remove(unsigned int us)
+{
+	int b = Bucket(us);
+	assert(counts[b] > 0 && total > 0);
+	--counts[b];
+	--total;
+}
+
+void TimeHistogram::Clear()
+{
+	fill(counts.begin(), counts.end(), 0);
+	total = 0;
+}
+
+float TimeHistogram::Percentile(float p) const
+{
+	if (total == 0)
+		return 0;
+	//the sample we want, counting from 1
+	unsigned int rank = max(1u, (unsigned int)(p * total + 0.5f));
+	unsigned int seen = 0;
+	for (int b = 0; b < NUM_BUCKETS; ++b)
+	{
+		seen += counts[b];
+		if (seen >= rank)
+			return (BucketLow(b) + BucketHigh(b) - 1) * 0.5f / 1000.f;
+	}
+	return Max();
+}
+
+float TimeHistogram::Max() const
+{
+	for (int b = NUM_BUCKETS - 1; b >= 0; --b)
+		if (counts[b] > 0)
+			return (BucketHigh(b) - 1) / 1000.f;
+	return 0;
+}
+
+//seconds to whole microseconds, clamped so silly values can't overflow
+unsigned int ToMicroseconds(float secs)
+{
+	return (unsigned int)max(0.f, min(secs * 1e6f, 4e9f));
+}
+
+void Telemetry::Add(float frameT, float updateT, float renderT)
+{
+	Sample s{ { ToMicroseconds(frameT), ToMicroseconds(updateT), ToMicroseconds(renderT) } };
+	if ((int)ring.size() < GC::TELEMETRY_WINDOW)
+		ring.push_back(s);
+	else
+	{
+		Sample& old = ring[next];
+		for (int c = 0; c < NUM_CHANNELS; ++c)
+			window[c].Remove(old.us[c]);
+		if (IsOver(old))
+			--windowOver;
+		old = s;
+		next = (next + 1) % GC::TELEMETRY_WINDOW;
+	}
+	for (int c = 0; c < NUM_CHANNELS; ++c)
+		window[c].Add(s.us[c]);
+	session.Add(s.us[Frame]);
+	if (IsOver(s))
+	{
+		++windowOver;
+		++sessionOver;
+	}
+	++totalFrames;
+	totalTime += frameT;
+	sinceExport += frameT;
+}
+
+void Telemetry::StartSession()
+{
+	session.Clear();
+	sessionOver = 0;
+}
+
+//fill in the percentiles from a histogram
+FrameSummary Summarise(const TimeHistogram& h, int overBudget)
+{
+	FrameSummary fs;
+	fs.frames = (int)h.total;
+	fs.p50 = h.Percentile(0.5f);
+	fs.p95 = h.Percentile(0.95f);
+	fs.p99 = h.Percentile(0.99f);
+	fs.max = h.Max();
+	fs.overBudget = overBudget;
+	return fs;
+}
+
+FrameSummary Telemetry::Summary(Channel c) const
+{
+	//over budget is a count of frames, it only goes with the frame channel
+	return Summarise(window[c], (c == Frame) ? windowOver : 0);
+}
+
+FrameSummary Telemetry::SessionSummary() const
+{
+	return Summarise(session, sessionOver);
+}
+
+void Telemetry::WriteCSV(ostream& os, bool header) const
+{
+	if (header)
+		os << "time,frames,channel,p50,p95,p99,max,over_budget\n";
+	for (int c = 0; c < NUM_CHANNELS; ++c)
+	{
+		FrameSummary fs = Summary((Channel)c);
+		os << totalTime << ',' << totalFrames << ',' << CHANNEL_NAMES[c] << ',' << fs.p50 << ',' << fs.p95
+			<< ',' << fs.p99 << ',' << fs.max << ',' << fs.overBudget << '\n';
+	}
+}
+
+void Telemetry::WriteJSON(ostream& os) const
+{
+	os << "{\n\t\"time\": " << totalTime << ",\n\t\"frames\": " << totalFrames
+		<< ",\n\t\"budget_ms\": " << budgetUs / 1000.f;
+	for (int c = 0; c < NUM_CHANNELS; ++c)
+	{
+		FrameSummary fs = Summary((Channel)c);
+		os << ",\n\t\"" << CHANNEL_NAMES[c] << "\": { \"frames\": " << fs.frames << ", \"p50\": " << fs.p50
+			<< ", \"p95\": " << fs.p95 << ", \"p99\": " << fs.p99 << ", \"max\": " << fs.max
+			<< ", \"over_budget\": " << fs.overBudget << " }";
+	}
+	os << "\n}\n";
+}
+
+bool Telemetry::Export()
+{
+	sinceExport = 0;
+	bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	if (json)
+	{
+		ofstream fs(path);
+		if (!fs.is_open())
+			return false;
+		WriteJSON(fs);
+		return !fs.fail();
+	}
+	//only a brand new file needs the column names
+	bool exists = ifstream(path).good();
+	ofstream fs(path, ios::app);
+	if (!fs.is_open())
+		return false;
+	WriteCSV(fs, !exists);
+	return !fs.fail();
+}
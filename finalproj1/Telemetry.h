@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+
+namespace GC
+{
+	const float FRAME_BUDGET = 1.f / 60.f;	//seconds a frame's update and render should take, anything longer is counted
+	const int TELEMETRY_WINDOW = 600;		//frames in the rolling window, ten seconds at 60fps
+	const float TELEMETRY_PERIOD = 10.f;	//seconds between writing the telemetry to disk
+}
+
+/*
+Counts times in microseconds using log-linear buckets (like HdrHistogram).
+Under 2*SUB every microsecond gets its own bucket, above that each power of
+two is split into SUB buckets, so a value is never more than about 3% out
+and the whole range of an unsigned int fits in under a thousand buckets
+*/
+struct TimeHistogram {
+	static const int SUB_BITS = 5;
+	static const int SUB = 1 << SUB_BITS;
+	static const int NUM_BUCKETS = (32 - SUB_BITS + 1) * SUB;
+
+	std::vector<unsigned int> counts = std::vector<unsigned int>(NUM_BUCKETS, 0);
+	unsigned int total = 0;		//values in all the buckets
+
+	void Add(unsigned int us) {
+		++counts[Bucket(us)];
+		++total;
+	}
+	//take back a value added earlier, for rolling windows
+	void Remove(unsigned int us);
+	void Clear();
+	/*
+	p - 0 to 1, e.g. 0.99 for the 99th percentile
+	returns - milliseconds, 0 if empty
+	*/
+	float Percentile(float p) const;
+	//the biggest value added, in milliseconds
+	float Max() const;
+
+	static int Bucket(unsigned int us);
+	//smallest and one past the biggest value in a bucket
+	static unsigned int BucketLow(int b);
+	static unsigned int BucketHigh(int b);
+};
+
+/*
+What a run of frames looked like, all times in milliseconds
+*/
+struct FrameSummary {
+	int frames = 0;
+	float p50 = 0, p95 = 0, p99 = 0, max = 0;
+	int overBudget = 0;		//frames whose update and render took longer than GC::FRAME_BUDGET
+};
+
+/*
+Frame, update and render times for the last few seconds, and frame time
+for the whole of the current game. The main loop adds one sample per frame
+and calls Export when Due to append the rolling figures to a file
+*/
+struct Telemetry {
+	enum Channel { Frame, Update, Render, NUM_CHANNELS };
+	static const char* CHANNEL_NAMES[NUM_CHANNELS];
+	struct Sample {
+		unsigned int us[NUM_CHANNELS];
+	};
+
+	TimeHistogram window[NUM_CHANNELS];	//the last GC::TELEMETRY_WINDOW frames
+	TimeHistogram session;				//frame times since StartSession
+	std::vector<Sample> ring;			//samples in the window, oldest overwritten first
+	int next = 0;						//where the next sample goes in ring
+	int windowOver = 0;					//frames over budget in the window
+	int sessionOver = 0;				//and since StartSession
+	long long totalFrames = 0;
+	float totalTime = 0;				//seconds of frames added
+	float sinceExport = 0;
+	unsigned int budgetUs = (unsigned int)(GC::FRAME_BUDGET * 1e6f);
+	std::string path = "telemetry.csv";	//.json writes the latest figures as JSON instead of adding CSV rows
+
+	/*
+	all times in seconds. Frames are paced to the same rate as the budget, so
+	frameT is always about the budget give or take waking up late, it's the
+	work (updateT + renderT) that's compared against the budget instead
+	*/
+	void Add(float frameT, float updateT, float renderT);
+	//did this sample's update and render go over the budget
+	bool IsOver(const Sample& s) const {
+		return s.us[Update] + s.us[Render] > budgetUs;
+	}
+	//a new game is starting, forget the session figures
+	void StartSession();
+	FrameSummary Summary(Channel c) const;
+	FrameSummary SessionSummary() const;
+	//time to write to disk?
+	bool Due() const {
+		return sinceExport >= GC::TELEMETRY_PERIOD;
+	}
+	//write to path, CSV or JSON depending on the extension
+	bool Export();
+	//one row per channel, header is the column names
+	void WriteCSV(std::ostream& os, bool header) const;
+	void WriteJSON(std::ostream& os) const;
+};
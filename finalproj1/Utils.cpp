@@ -14,22 +14,3 @@ void DebugPrint(const string& mssg1, const string& mssg2)
 	}
 }
 
-void SpawnTimer::Reset(float _delay, float _decayDelay, float _decayMultiplier) {
-	timer = 0;
-	decayTimer = 0;
-	delay = originalDelay;
-	if (_delay != -1)
-		originalDelay = delay = _delay;
-	if (_decayDelay != -1) 
-		decayDelay = _decayDelay;
-}
-
-bool SpawnTimer::Cycle(float elapsed) {
-	timer += elapsed;
-	decayTimer += elapsed;
-	if (decayDelay > 0 && decayTimer >= decayDelay) {
-		decayTimer = 0;
-		delay *= 0.99f;
-	}
-	return (timer >= delay);
-}
@@ -14,33 +14,26 @@ struct Dim2Df
 };
 
 /*
-A crude attempt to control difficulty - there are many ways to do that!
-Things get created or spawned at timed regular intervals
-The rate at which these spawn events happen gets faster and 
-faster to make the game get harder and harder.
+Small fast random number generator (xorshift32). All of its state is one
+number, so it can be saved and restored with the rest of the game and a
+replay always gets the same numbers, which rand() can't promise
 */
-struct SpawnTimer {
-	float timer=0;				//a clock to time the next spawn
-	float decayTimer = 0;		//a clock to time when the spawns should get faster
+struct Rng {
+	unsigned int state = 2463534242u;	//never zero, xorshift would get stuck
 
-	float delay=1, originalDelay=1;	//how long to wait before the next spawn
-	float decayDelay = 0;			//how long to wait before the spawning gets faster
-	float decayMultiplier = 0.99f;  //when spawning gets faster, by what percentage does the delay fall
-
-	/*
-	Reset the clocks, we can do that by specifying all new delay/decay 
-	time values, or leave that blank, it will remember the old values
-	and just restart the timers.
-	*/
-	void Reset(float _delay = -1, float _decayDelay = -1, float _decayMultiplier = -1);
-	/*
-	Call this every updated to keep the clock ticking
-	If it returns true then you need to spawn something. Note that
-	this will keep returning true, once the time is right, until you
-	reset it. Like an alarm that goes off at set time intervals, but
-	once it does off, it doesn't stop until you reset it.
-	*/
-	bool Cycle(float elapsed);
+	void Seed(unsigned int seed) {
+		state = (seed != 0) ? seed : 2463534242u;
+	}
+	unsigned int Next() {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	//0 to n-1, n must be more than zero
+	int Range(int n) {
+		return (int)(Next() % (unsigned int)n);
+	}
 };
 
 /*
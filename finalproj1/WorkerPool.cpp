@@ -0,0 +1,94 @@
+#include <assert.h>
+
+#include "WorkerPool.h"
+
+using namespace std;
+
+void WorkerPool::Init(int numThreads)
+{
+	assert(threads.empty());
+	if (numThreads < 0)
+		numThreads = (int)thread::hardware_concurrency();
+	quit = false;
+	for (int i = 1; i < numThreads; ++i)
+		threads.push_back(thread(&WorkerPool::WorkerLoop, this));
+}
+
+void WorkerPool::Shutdown()
+{
+	{
+		lock_guard<mutex> lock(mtx);
+		quit = true;
+	}
+	cvWork.notify_all();
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	threads.clear();
+}
+
+void WorkerPool::Run(int num, JobFn fn, void *data)
+{
+	assert(fn);
+	if (num <= 0)
+		return;
+	if (threads.empty() || num == 1)
+	{
+		for (int i = 0; i < num; ++i)
+			fn(data, i);
+		return;
+	}
+	{
+		unique_lock<mutex> lock(mtx);
+		//a late waking worker could still be looking at the last batch
+		cvDone.wait(lock, [this] { return numBusy == 0; });
+		pFn = fn;
+		pData = data;
+		numJobs = num;
+		nextJob = 0;
+		jobsDone = 0;
+		++batch;
+	}
+	cvWork.notify_all();
+	DoJobs(num, fn, data);
+
+	unique_lock<mutex> lock(mtx);
+	cvDone.wait(lock, [this, num] { return jobsDone == num; });
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned seen = 0;
+	unique_lock<mutex> lock(mtx);
+	while (true)
+	{
+		cvWork.wait(lock, [this, &seen] { return quit || batch != seen; });
+		if (quit)
+			return;
+		seen = batch;
+		JobFn fn = pFn;
+		void *data = pData;
+		int num = numJobs;
+		++numBusy;
+		lock.unlock();
+
+		DoJobs(num, fn, data);
+
+		lock.lock();
+		--numBusy;
+		cvDone.notify_all();
+	}
+}
+
+void WorkerPool::DoJobs(int num, JobFn fn, void *data)
+{
+	int job;
+	while ((job = nextJob.fetch_add(1)) < num)
+	{
+		fn(data, job);
+		if (jobsDone.fetch_add(1) + 1 == num)
+		{
+			lock_guard<mutex> lock(mtx);
+			cvDone.notify_all();
+		}
+	}
+}
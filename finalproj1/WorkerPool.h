@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+A handful of threads that sleep until there's work to share out
+Work is a number of jobs, each job is one call to a plain function pointer
+so handing work out never allocates any memory
+*/
+struct WorkerPool {
+	/*
+	pData - whatever the caller wants to pass through
+	job - which job this is, 0 to numJobs-1
+	*/
+	typedef void(*JobFn)(void* pData, int job);
+
+	std::vector<std::thread> threads;	//the calling thread helps out too, so this is one less than the total
+	std::mutex mtx;						//protects everything below that isn't atomic
+	std::condition_variable cvWork;		//workers wait on this for a new batch of jobs
+	std::condition_variable cvDone;		//Run() waits on this for the batch to finish
+	JobFn pFn = nullptr;				//what to call for each job in the current batch
+	void *pData = nullptr;
+	int numJobs = 0;					//jobs in the current batch
+	unsigned batch = 0;					//goes up by one every Run() so workers know there's new work
+	int numBusy = 0;					//workers still looking at the current batch
+	bool quit = false;
+	std::atomic<int> nextJob{ 0 };		//next job to hand out
+	std::atomic<int> jobsDone{ 0 };		//how many jobs have finished
+
+	~WorkerPool() {
+		Shutdown();
+	}
+	//start the threads, -1 means one per core with the calling thread counting as one
+	void Init(int numThreads = -1);
+	//stop and join all the threads
+	void Shutdown();
+	//total threads that will work on a batch, including the caller
+	int GetNumThreads() const {
+		return (int)threads.size() + 1;
+	}
+	/*
+	Call fn once for every job from 0 to numJobs-1, spread across the threads
+	Doesn't return until every job has finished
+	*/
+	void Run(int numJobs, JobFn fn, void *pData);
+	//what each worker thread sits in
+	void WorkerLoop();
+	//keep taking jobs until there are none left
+	void DoJobs(int num, JobFn fn, void *pData);
+};
@@ -1,66 +1,194 @@
 
+#include <fstream>
+#include <thread>
+
 #include "Game.h"
+#include "Bench.h"
+#include "RenderFrame.h"
+#include "FramePacer.h"
+#include "DynamicRes.h"
 
 
 using namespace sf;
 using namespace std;
 
 
+/*
+With -pipelined this runs on its own thread, drawing whatever the simulation
+last finished while the simulation gets on with the next frame
+*/
+void RenderLoop(RenderWindow& window, RenderFrames& frames)
+{
+	window.setActive(true);
+	SFMLBackend gfx(window);
+	while (RenderFrame *pFrame = frames.Acquire())
+	{
+		gfx.stats.Reset();
+		pFrame->Play(gfx);
+		window.display();
+	}
+	window.setActive(false);
+}
 
-
-int main()
+int main(int argc, char* argv[])
 {
+	const Vector2u windowSz(861, 384);
+
+	//-bench runs the timing tests instead of the game and writes the results to bench.txt
+	if (argc > 1 && string(argv[1]) == "-bench")
+	{
+		ofstream fs("bench.txt");
+		RunBenchmarks(fs);
+		return EXIT_SUCCESS;
+	}
+	//-layouts makes rock layouts offline so the game doesn't have to at the start
+	if (argc > 1 && string(argv[1]) == "-layouts")
+	{
+		vector<DiskLayout> layouts;
+		GenerateRockLayouts(windowSz, 16, layouts);
+		return SaveLayouts("data/rock_layouts.txt", layouts) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	//-golden draws set scenes in memory and checks them against saved images, results go in golden.txt
+	//-golden -update saves them as the new references instead
+	if (argc > 1 && string(argv[1]) == "-golden")
+	{
+		ofstream fs("golden.txt");
+		bool update = argc > 2 && string(argv[2]) == "-update";
+		return RunGoldenTests(windowSz, fs, update) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	// Create the main window
-	RenderWindow window(VideoMode(861, 384), "Legend Quest 2D");
+	RenderWindow window(VideoMode(windowSz.x, windowSz.y), "Legend Quest 2D");
+	SFMLBackend gfx(window);
+	InputState input;
 	
 	Game game;
-	game.Init(window);
+	game.Init(window.getSize());
+
+	//-pipelined updates on this thread and draws on another, so a frame costs the slower of the two rather than both
+	//-fps <rate> changes the frame limit, 0 takes it off
+	//-fixedres always draws the game at the window's resolution
+	bool pipelined = false;
+	float fps = GC::TARGET_FPS;
+	bool scaleRes = true;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (string(argv[i]) == "-fps" && i + 1 < argc)
+			fps = (float)atof(argv[i + 1]);
+		else if (string(argv[i]) == "-fixedres")
+			scaleRes = false;
+		else if (string(argv[i]) == "-pipelined")
+			pipelined = true;
+	}
+	RenderFrames frames;
+	thread renderer;
+	if (pipelined)
+	{
+		//room for every object and particle as a sprite and the corners of every bullet
+		frames.Init(game.objects.size() + GC::NUM_PARTICLES, GC::MAX_PROJECTILES * 4);
+		window.setActive(false);	//the window can only be drawn in by one thread, hand it over
+		renderer = thread(RenderLoop, ref(window), ref(frames));
+	}
+	FramePacer pacer;
+	pacer.Init(fps);
+	DynamicRes dynRes;
+	dynRes.Init((fps > 0) ? 1.f / fps : GC::FRAME_BUDGET);
+	bool drawn = false;				//has anything been drawn yet
+	//off screen targets are made here when the window changes size, Game::Render mustn't allocate
+	Vector2u targetSz(0, 0);
 
 	Clock clock;
+	Clock perfClock;	//times the update and render separately for the telemetry
 
 	// Start the game loop 
 	while (window.isOpen())
 	{
-		
-		bool fire = false;
-		char key = -1;
-		// Process events
+		// Process events, everything after this only looks at the snapshot
+		input.BeginFrame();
+		//a menu that's already on screen can't change without input, so sleep until there is some
+		bool idle = game.IsStatic() && drawn;
+		if (idle)
+			WaitForInput(window, input);
+		//whatever else arrived meanwhile, any of these can change the screen too
 		Event event;
 		while (window.pollEvent(event))
+			input.Handle(event);
+		if (input.quit)
 		{
-			// Close window: exit
-			if (event.type == Event::Closed) 
-				window.close();
-			else if (event.type == Event::TextEntered)
-			{
-				if (event.text.unicode == GC::ESCAPE_KEY)
-					window.close(); 
-				if (isdigit(event.text.unicode) || isalpha(event.text.unicode))
-					key = static_cast<char>(event.text.unicode);
-				else if (event.text.unicode == GC::BACKSPACE_KEY && !game.metrics.name.empty())
-					game.metrics.name = game.metrics.name.substr(0, game.metrics.name.length() - 1);
-			}
-			else if (event.type == Event::KeyReleased)
+			if (renderer.joinable())
 			{
-				if (event.key.code == Keyboard::Space)
-					fire = true; 
-				//this isn't the only way to monitor for a fire key press, 
-				//could also use Keyboard::isKeyPressed(Keyboard::Space), either is fine
-				//isKeyPressed() can be called from anywhere, but doesn't wait for you to let go
+				frames.Stop();
+				renderer.join();
 			}
-		} 
-
-		// Clear screen
-		window.clear();
+			window.close();
+		}
+		if (input.WasReleased(Keyboard::F1))
+			game.debug = !game.debug;
+		if (window.isOpen() && window.getSize() != targetSz)
+		{
+			targetSz = window.getSize();
+			if (!pipelined)
+				game.layers.Resize(targetSz);
+			if (scaleRes && !pipelined)
+				dynRes.Resize(targetSz);
+		}
 
 		float elapsed = clock.getElapsedTime().asSeconds();
 		clock.restart();
 		
-		game.Update(window, elapsed, fire, key);
-		game.Render(window, elapsed);
+		perfClock.restart();
+		game.Update(window.getSize(), elapsed, input);
+		float updateT = perfClock.restart().asSeconds();
+		//nothing to show for e.g. a mouse move over a menu, keep what's there
+		bool redraw = !idle || input.changed;
+		if (redraw && pipelined)
+		{
+			//only written down here, the render thread does the drawing
+			RenderFrame& frame = frames.BeginWrite(window.getSize());
+			frame.Clear();
+			game.Render(frame, elapsed);
+			frames.Publish();
+		}
+		else if (redraw && scaleRes && game.mode == Game::Mode::GAME)
+		{
+			//the world may be drawn smaller and stretched to fit, the HUD goes on top at full resolution
+			gfx.stats.Reset();
+			game.Render(dynRes.Begin(window.getSize()), elapsed, false);
+			dynRes.End(gfx);
+			game.RenderHUD(gfx, elapsed, game.font);
+		}
+		else if (redraw)
+		{
+			// Clear screen
+			gfx.stats.Reset();
+			gfx.Clear();
+			game.Render(gfx, elapsed);
+		}
+		float renderT = perfClock.restart().asSeconds();
 		
 		// Update the window
-		window.display();
+		if (redraw && !pipelined)
+			window.display();
+		float workT = updateT + renderT + perfClock.restart().asSeconds();
+		if (scaleRes && !pipelined && game.mode == Game::Mode::GAME)
+		{
+			dynRes.AddFrame(workT);
+			game.resScale = dynRes.GetScale();
+		}
+		drawn = drawn || redraw;
+
+		//time spent asleep waiting for input isn't a slow frame
+		Telemetry& telemetry = game.metrics.telemetry;
+		if (!idle)
+			telemetry.Add(elapsed, updateT, renderT);
+		game.EndFrame();
+		if (telemetry.Due())
+			telemetry.Export();
+		if (game.IsStatic())
+			pacer.Restart();
+		else
+			pacer.Wait();
 	}
 
 	return EXIT_SUCCESS;